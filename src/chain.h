@@ -35,4 +35,13 @@ struct Chain {
 	uint64_t data;
 };
 
+// a link that carries the link prefetch_distance
+// hops further down the chain, used in place of
+// Chain when the experiment prefetches
+struct Lookahead {
+	Chain link;
+	Chain* ahead;
+	uint64_t pad;	// keeps the link size a power of two
+};
+
 #endif
@@ -22,12 +22,17 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <algorithm>
 #if defined(NUMA)
 #include <numa.h>
 #endif
 
 // Local includes
 #include "chain.h"
+#include "native.h"
+#include "trace.h"
+#include "layout.h"
+#include "memory.h"
 
 
 //
@@ -48,24 +53,56 @@ Experiment::Experiment() :
     pages_per_chain  (DEFAULT_PAGES_PER_CHAIN),
     chains_per_thread(DEFAULT_CHAINS_PER_THREAD),
     bytes_per_thread (DEFAULT_BYTES_PER_THREAD),
+    mlp              (false),
     num_threads      (DEFAULT_THREADS),
     bytes_per_test   (DEFAULT_BYTES_PER_TEST),
     loop_length      (DEFAULT_LOOPLENGTH),
+    unroll           (DEFAULT_UNROLL),
     seconds          (DEFAULT_SECONDS),
     iterations       (DEFAULT_ITERATIONS),
     experiments      (DEFAULT_EXPERIMENTS),
     prefetch_hint    (NONE),
+    prefetch_distance(DEFAULT_PREFETCH_DISTANCE),
 	mem_operation    (NA),
+    read_percent     (100),
+    memory_order     (RELAXED),
     output_mode      (TABLE),
+#if defined(HAVE_JIT)
+    kernel           (JIT),
+#else
+    kernel           (NATIVE),
+#endif
+    work             (NOP),
     access_pattern   (RANDOM),
     stride           (1),
+    window           (0),
+    zipf_theta       (0),
+    trace_file       (NULL),
+    trace            (NULL),
+    link_offset      (0),
+    random_offset    (false),
+    split            (UNSPLIT),
+    pages            (SYSTEM_PAGES),
+    backing_page_size(0),
+    prefault         (NO_PREFAULT),
+    lock_memory      (false),
+    backing_file     (NULL),
+    backing_fd       (-1),
+    cold             (false),
+    pages_placed     (0),
+    pages_resident   (0),
     numa_placement   (LOCAL),
     offset_or_mask   (0),
     placement_map    (NULL),
     thread_domain    (NULL),
     chain_domain     (NULL),
     numa_max_domain  (0),
-    num_numa_domains (1)
+    num_numa_domains (1),
+    seed             (0),
+    build_threads    (1),
+    save_file        (NULL),
+    load_file        (NULL),
+    layout           (NULL)
 {
 }
 
@@ -78,15 +115,65 @@ Experiment::~Experiment() {
 // -p or --page             bytes per page  (page size)
 // -c or --chain            bytes per chain (used to compute pages per chain)
 // -r or --references       chains per thread (memory loading)
+// --mlp                    sweep the chains per thread from 1 to the above
+// --seed                   seed of the random chain layouts
+// --build-threads          threads building each chain
+// --save-chains            file to save the chain layouts to
+// --load-chains            file to load the chain layouts from
+// --offset                 offset of the links in their lines
+//         <bytes>          the same offset in every line
+//         random           an aligned offset drawn for every line
+// --split                  make the next pointer straddle a boundary
+//         line             two cache lines
+//         page             two pages, with one link per page
+// --pages                  pages backing the chains
+//         system           the kernel's transparent huge page policy (default)
+//         4k               small pages only
+//         thp              transparent huge pages
+//         2m               2 MB hugetlbfs pages
+//         1g               1 GB hugetlbfs pages
+// --prefault               fault in the chains before building them
+//         none             while building them (default)
+//         populate         all at once, by the kernel
+//         touch            by build-threads threads in the chain's domain
+// --mlock                  lock the chains in memory
+// --backing                memory backing the chains
+//         anon             anonymous memory (default)
+//         file:<path>      a file created at <path>, mapped shared
+// --cold                   evict the chains before each experiment
 // -t or --threads          number of threads (concurrency and contention)
 // -i or --iters            iterations
 // -e or --experiments      experiments
-// -g or --loop				cycles to execute for each iteration (latency hiding)
+// -g or --loop				instructions to execute for each iteration (latency hiding)
+// -u or --unroll			links to chase per end-of-loop test
 // -f or --prefetch			use of prefetching
+// -d or --prefetch-distance	number of links to prefetch ahead
 // -a or --access           memory access pattern
 //         random           random access pattern
+//         random-full      one random cycle over all lines
+//         window <size>    random within windows, windows in order
+//         zipf <theta>     lines recur with zipf frequencies
+//         trace <file>     lines in the order of a recorded trace
 //         forward <stride> exclusive OR and mask
 //         reverse <stride> addition and offset
+// -k or --kernel           benchmark code generation
+//         jit              generated at run time (default)
+//         native           compiled C++ (the only choice without asmjit)
+//         stream-copy      STREAM copy over the chain memory
+//         stream-scale     STREAM scale over the chain memory
+//         stream-add       STREAM add over the chain memory
+//         stream-triad     STREAM triad over the chain memory
+//         fault            first touch of freshly mapped chain memory
+// --work                   instructions of the inner loop
+//         nop              no operation (default)
+//         dep              dependent integer additions
+//         indep            independent integer additions
+//         fma              dependent floating point multiply-adds
+// --order                  ordering of atomic operations
+//         relaxed          no ordering (default)
+//         acquire          acquire semantics
+//         release          release semantics
+//         acq_rel          acquire and release semantics
 // -o or --output           output mode
 //         hdr              header only
 //         csv              csv only
@@ -110,6 +197,133 @@ int Experiment::parse_args(int argc, char* argv[]) {
 		} else if (strcasecmp(argv[i], "-x") == 0
 				|| strcasecmp(argv[i], "--strict") == 0) {
 			this->strict = true;
+		} else if (strcasecmp(argv[i], "--mlp") == 0) {
+			this->mlp = true;
+		} else if (strcasecmp(argv[i], "--seed") == 0) {
+			i++;
+			if (i == argc) {
+				strncpy(errorString, "seed missing", errorStringSize);
+				error = true;
+				break;
+			}
+			this->seed = Experiment::parse_number(argv[i]);
+		} else if (strcasecmp(argv[i], "--save-chains") == 0) {
+			i++;
+			if (i == argc) {
+				strncpy(errorString, "chain file missing", errorStringSize);
+				error = true;
+				break;
+			}
+			this->save_file = argv[i];
+		} else if (strcasecmp(argv[i], "--load-chains") == 0) {
+			i++;
+			if (i == argc) {
+				strncpy(errorString, "chain file missing", errorStringSize);
+				error = true;
+				break;
+			}
+			this->load_file = argv[i];
+		} else if (strcasecmp(argv[i], "--offset") == 0) {
+			i++;
+			if (i == argc) {
+				strncpy(errorString, "link offset missing", errorStringSize);
+				error = true;
+				break;
+			}
+			if (strcasecmp(argv[i], "random") == 0) {
+				this->random_offset = true;
+			} else {
+				this->link_offset = Experiment::parse_number(argv[i]);
+			}
+		} else if (strcasecmp(argv[i], "--split") == 0) {
+			i++;
+			if (i == argc) {
+				strncpy(errorString, "split boundary missing", errorStringSize);
+				error = true;
+				break;
+			}
+			if (strcasecmp(argv[i], "line") == 0) {
+				this->split = LINE;
+			} else if (strcasecmp(argv[i], "page") == 0) {
+				this->split = PAGE;
+			} else {
+				snprintf(errorString, errorStringSize, "invalid split boundary -- '%s'", argv[i]);
+				error = true;
+				break;
+			}
+		} else if (strcasecmp(argv[i], "--pages") == 0) {
+			i++;
+			if (i == argc) {
+				strncpy(errorString, "type of pages missing", errorStringSize);
+				error = true;
+				break;
+			}
+			if (strcasecmp(argv[i], "system") == 0) {
+				this->pages = SYSTEM_PAGES;
+			} else if (strcasecmp(argv[i], "4k") == 0) {
+				this->pages = SMALL_PAGES;
+			} else if (strcasecmp(argv[i], "thp") == 0) {
+				this->pages = TRANSPARENT_HUGE_PAGES;
+			} else if (strcasecmp(argv[i], "2m") == 0) {
+				this->pages = HUGE_PAGES_2M;
+			} else if (strcasecmp(argv[i], "1g") == 0) {
+				this->pages = HUGE_PAGES_1G;
+			} else {
+				snprintf(errorString, errorStringSize, "invalid type of pages -- '%s'", argv[i]);
+				error = true;
+				break;
+			}
+		} else if (strcasecmp(argv[i], "--prefault") == 0) {
+			i++;
+			if (i == argc) {
+				strncpy(errorString, "type of prefault missing", errorStringSize);
+				error = true;
+				break;
+			}
+			if (strcasecmp(argv[i], "none") == 0) {
+				this->prefault = NO_PREFAULT;
+			} else if (strcasecmp(argv[i], "populate") == 0) {
+				this->prefault = POPULATE;
+			} else if (strcasecmp(argv[i], "touch") == 0) {
+				this->prefault = TOUCH;
+			} else {
+				snprintf(errorString, errorStringSize, "invalid type of prefault -- '%s'", argv[i]);
+				error = true;
+				break;
+			}
+		} else if (strcasecmp(argv[i], "--mlock") == 0) {
+			this->lock_memory = true;
+		} else if (strcasecmp(argv[i], "--backing") == 0) {
+			i++;
+			if (i == argc) {
+				strncpy(errorString, "memory backing missing", errorStringSize);
+				error = true;
+				break;
+			}
+			if (strcasecmp(argv[i], "anon") == 0) {
+				this->backing_file = NULL;
+			} else if (strncasecmp(argv[i], "file:", 5) == 0 && argv[i][5] != '\0') {
+				this->backing_file = argv[i] + 5;
+			} else {
+				snprintf(errorString, errorStringSize, "invalid memory backing -- '%s'", argv[i]);
+				error = true;
+				break;
+			}
+		} else if (strcasecmp(argv[i], "--cold") == 0) {
+			this->cold = true;
+		} else if (strcasecmp(argv[i], "--build-threads") == 0) {
+			i++;
+			if (i == argc) {
+				strncpy(errorString, "amount of build threads missing", errorStringSize);
+				error = true;
+				break;
+			}
+			this->build_threads = Experiment::parse_number(argv[i]);
+			if (this->build_threads == 0) {
+				strncpy(errorString, "invalid amount of build threads", errorStringSize);
+				error = true;
+				break;
+			}
 		} else if (strcasecmp(argv[i], "-s") == 0
 				|| strcasecmp(argv[i], "--seconds") == 0) {
 			i++;
@@ -238,6 +452,20 @@ int Experiment::parse_args(int argc, char* argv[]) {
 				error = true;
 				break;
 			}
+		} else if (strcasecmp(argv[i], "-u") == 0
+				|| strcasecmp(argv[i], "--unroll") == 0) {
+			i++;
+			if (i == argc) {
+				strncpy(errorString, "unroll factor missing", errorStringSize);
+				error = true;
+				break;
+			}
+			this->unroll = Experiment::parse_number(argv[i]);
+			if (this->unroll == 0) {
+				strncpy(errorString, "invalid unroll factor", errorStringSize);
+				error = true;
+				break;
+			}
 		} else if (strcasecmp(argv[i], "-f") == 0
 				|| strcasecmp(argv[i], "--prefetch") == 0) {
 			i++;
@@ -261,7 +489,22 @@ int Experiment::parse_args(int argc, char* argv[]) {
 				error = true;
 				break;
 			}
+		} else if (strcasecmp(argv[i], "-d") == 0
+				|| strcasecmp(argv[i], "--prefetch-distance") == 0) {
+			i++;
+			if (i == argc) {
+				strncpy(errorString, "prefetch distance missing", errorStringSize);
+				error = true;
+				break;
+			}
+			this->prefetch_distance = Experiment::parse_number(argv[i]);
+			if (this->prefetch_distance == 0) {
+				strncpy(errorString, "invalid prefetch distance", errorStringSize);
+				error = true;
+				break;
+			}
 		}else if (strcasecmp(argv[i], "-m") == 0
+				|| strcasecmp(argv[i], "--operation") == 0
 				|| strcasecmp(argv[i], "--operartion") == 0) {
 			i++;
 			if (i == argc) {
@@ -279,11 +522,88 @@ int Experiment::parse_args(int argc, char* argv[]) {
 				this->mem_operation = Experiment::LOAD_ALL;
 			} else if (strcasecmp(argv[i], "store_all") == 0) {
 				this->mem_operation = Experiment::STORE_ALL;
+			} else if (strcasecmp(argv[i], "load_line") == 0) {
+				this->mem_operation = Experiment::LOAD_LINE;
+			} else if (strcasecmp(argv[i], "store_line") == 0) {
+				this->mem_operation = Experiment::STORE_LINE;
+			} else if (strcasecmp(argv[i], "store_nt") == 0) {
+				this->mem_operation = Experiment::STORE_NT;
+			} else if (strcasecmp(argv[i], "store_line_nt") == 0) {
+				this->mem_operation = Experiment::STORE_LINE_NT;
+			} else if (strcasecmp(argv[i], "zero_line") == 0) {
+				this->mem_operation = Experiment::ZERO_LINE;
+			} else if (strcasecmp(argv[i], "flush") == 0) {
+				this->mem_operation = Experiment::FLUSH;
+			} else if (strcasecmp(argv[i], "atomic_add") == 0) {
+				this->mem_operation = Experiment::ATOMIC_ADD;
+			} else if (strcasecmp(argv[i], "cas") == 0) {
+				this->mem_operation = Experiment::CAS;
+			} else if (strcasecmp(argv[i], "swap") == 0) {
+				this->mem_operation = Experiment::SWAP;
+			} else if (strcasecmp(argv[i], "load_acquire") == 0) {
+				this->mem_operation = Experiment::LOAD_ACQUIRE;
+			} else if (strcasecmp(argv[i], "load_acquire_pc") == 0) {
+				this->mem_operation = Experiment::LOAD_ACQUIRE_PC;
+			} else if (strcasecmp(argv[i], "store_release") == 0) {
+				this->mem_operation = Experiment::STORE_RELEASE;
+			} else if (strcasecmp(argv[i], "fence") == 0) {
+				this->mem_operation = Experiment::FENCE;
+			} else if (strcasecmp(argv[i], "fence_load") == 0) {
+				this->mem_operation = Experiment::FENCE_LOAD;
+			} else if (strncasecmp(argv[i], "mix:", 4) == 0
+					&& '0' <= argv[i][4] && argv[i][4] <= '9') {
+				this->mem_operation = Experiment::MIX;
+				this->read_percent = Experiment::parse_number(argv[i] + 4);
+				if (100 < this->read_percent) {
+					strncpy(errorString, "invalid read percentage of mix operation", errorStringSize);
+					error = true;
+					break;
+				}
 			}  else {
 				snprintf(errorString, errorStringSize, "invalid type of operartion -- '%s'", argv[i]);
 				error = true;
 				break;
 			}
+		} else if (strcasecmp(argv[i], "--work") == 0) {
+			i++;
+			if (i == argc) {
+				strncpy(errorString, "type of work missing", errorStringSize);
+				error = true;
+				break;
+			}
+			if (strcasecmp(argv[i], "nop") == 0) {
+				this->work = NOP;
+			} else if (strcasecmp(argv[i], "dep") == 0) {
+				this->work = DEPENDENT;
+			} else if (strcasecmp(argv[i], "indep") == 0) {
+				this->work = INDEPENDENT;
+			} else if (strcasecmp(argv[i], "fma") == 0) {
+				this->work = FMA;
+			} else {
+				snprintf(errorString, errorStringSize, "invalid type of work -- '%s'", argv[i]);
+				error = true;
+				break;
+			}
+		} else if (strcasecmp(argv[i], "--order") == 0) {
+			i++;
+			if (i == argc) {
+				strncpy(errorString, "memory order missing", errorStringSize);
+				error = true;
+				break;
+			}
+			if (strcasecmp(argv[i], "relaxed") == 0) {
+				this->memory_order = RELAXED;
+			} else if (strcasecmp(argv[i], "acquire") == 0) {
+				this->memory_order = ACQUIRE;
+			} else if (strcasecmp(argv[i], "release") == 0) {
+				this->memory_order = RELEASE;
+			} else if (strcasecmp(argv[i], "acq_rel") == 0) {
+				this->memory_order = ACQ_REL;
+			} else {
+				snprintf(errorString, errorStringSize, "invalid memory order -- '%s'", argv[i]);
+				error = true;
+				break;
+			}
 		} else if (strcasecmp(argv[i], "-a") == 0
 				|| strcasecmp(argv[i], "--access") == 0) {
 			i++;
@@ -294,6 +614,40 @@ int Experiment::parse_args(int argc, char* argv[]) {
 			}
 			if (strcasecmp(argv[i], "random") == 0) {
 				this->access_pattern = RANDOM;
+			} else if (strcasecmp(argv[i], "random-full") == 0) {
+				this->access_pattern = RANDOM_FULL;
+			} else if (strcasecmp(argv[i], "zipf") == 0) {
+				this->access_pattern = ZIPF;
+				i++;
+				if (i == argc) {
+					strncpy(errorString, "skew of zipf memory access pattern missing", errorStringSize);
+					error = true;
+					break;
+				}
+				this->zipf_theta = Experiment::parse_real(argv[i]);
+			} else if (strcasecmp(argv[i], "trace") == 0) {
+				this->access_pattern = TRACE;
+				i++;
+				if (i == argc) {
+					strncpy(errorString, "file of trace memory access pattern missing", errorStringSize);
+					error = true;
+					break;
+				}
+				this->trace_file = argv[i];
+			} else if (strcasecmp(argv[i], "window") == 0) {
+				this->access_pattern = WINDOW;
+				i++;
+				if (i == argc) {
+					strncpy(errorString, "size of windowed memory access pattern missing", errorStringSize);
+					error = true;
+					break;
+				}
+				this->window = Experiment::parse_number(argv[i]);
+				if (this->window == 0) {
+					strncpy(errorString, "invalid size of windowed memory access pattern", errorStringSize);
+					error = true;
+					break;
+				}
 			} else if (strcasecmp(argv[i], "forward") == 0) {
 				this->access_pattern = STRIDED;
 				i++;
@@ -327,6 +681,39 @@ int Experiment::parse_args(int argc, char* argv[]) {
 				error = true;
 				break;
 			}
+		} else if (strcasecmp(argv[i], "-k") == 0
+				|| strcasecmp(argv[i], "--kernel") == 0) {
+			i++;
+			if (i == argc) {
+				strncpy(errorString, "type of kernel missing", errorStringSize);
+				error = true;
+				break;
+			}
+			if (strcasecmp(argv[i], "jit") == 0) {
+#if defined(HAVE_JIT)
+				this->kernel = JIT;
+#else
+				strncpy(errorString, "jit kernel not available in this build", errorStringSize);
+				error = true;
+				break;
+#endif
+			} else if (strcasecmp(argv[i], "native") == 0) {
+				this->kernel = NATIVE;
+			} else if (strcasecmp(argv[i], "stream-copy") == 0) {
+				this->kernel = STREAM_COPY;
+			} else if (strcasecmp(argv[i], "stream-scale") == 0) {
+				this->kernel = STREAM_SCALE;
+			} else if (strcasecmp(argv[i], "stream-add") == 0) {
+				this->kernel = STREAM_ADD;
+			} else if (strcasecmp(argv[i], "stream-triad") == 0) {
+				this->kernel = STREAM_TRIAD;
+			} else if (strcasecmp(argv[i], "fault") == 0) {
+				this->kernel = FAULT;
+			} else {
+				snprintf(errorString, errorStringSize, "invalid type of kernel -- '%s'", argv[i]);
+				error = true;
+				break;
+			}
 		} else if (strcasecmp(argv[i], "-o") == 0
 				|| strcasecmp(argv[i], "--output") == 0) {
 			i++;
@@ -417,24 +804,177 @@ int Experiment::parse_args(int argc, char* argv[]) {
 		printf("    [-p|--page]        <number>    # bytes per page (page size)\n");
 		printf("    [-c|--chain]       <number>    # bytes per chain (used to compute pages per chain)\n");
 		printf("    [-r|--references]  <number>    # chains per thread (memory loading)\n");
+		printf("    [--mlp]                        # sweep the chains per thread from 1 to <number>\n");
+		printf("    [--seed]           <number>    # seed of the random chain layouts (default 0)\n");
+		printf("    [--build-threads]  <number>    # threads building each chain (default 1)\n");
+		printf("    [--save-chains]    <file>      # save the chain layouts to <file>\n");
+		printf("    [--load-chains]    <file>      # load the chain layouts from <file> instead of building them\n");
+		printf("    [--offset]         <offset>    # offset of the links in their lines, in bytes or random\n");
+		printf("    [--split]          <boundary>  # make the next pointer straddle two lines or pages\n");
+		printf("    [--pages]          <pages>     # pages backing the chains\n");
+		printf("    [--prefault]       <prefault>  # fault in the chains before building them\n");
+		printf("    [--mlock]                      # lock the chains in memory\n");
+		printf("    [--backing]        <backing>   # memory backing the chains\n");
+		printf("    [--cold]                       # evict the chains before each experiment\n");
 		printf("    [-t|--threads]     <number>    # number of threads (concurrency and contention)\n");
 		printf("    [-i|--iterations]  <number>    # iterations per experiment\n");
 		printf("    [-e|--experiments] <number>    # experiments\n");
 		printf("    [-a|--access]      <pattern>   # memory access pattern\n");
 		printf("    [-m|--operation]   <operation> # memory operation\n");
+		printf("    [-k|--kernel]      <kernel>    # benchmark code generation\n");
+		printf("    [--order]          <order>     # ordering of atomic operations\n");
 		printf("    [-o|--output]      <format>    # output format\n");
 		printf("    [-n|--numa]        <placement> # numa placement\n");
 		printf("    [-s|--seconds]     <number>    # run each experiment for <number> seconds\n");
-		printf("    [-g|--loop]        <number>    # cycles to execute for each iteration (latency hiding)\n");
+		printf("    [-g|--loop]        <number>    # instructions to execute for each iteration (latency hiding)\n");
+		printf("    [--work]           <work>      # instructions of the loop\n");
+		printf("    [-u|--unroll]      <number>    # links chased per end-of-loop test\n");
 		printf("    [-f|--prefetch]    <hint>      # use of prefetching\n");
+		printf("    [-d|--prefetch-distance] <number> # prefetch the link <number> hops ahead\n");
 		printf("    [-x|--strict]                  # fail rather than adjust options to sensible values\n");
 		printf("\n");
 		printf("<pattern> is selected from the following:\n");
 		printf("    random                         # all chains are accessed randomly\n");
+		printf("    random-full                    # one uniformly random cycle over all lines of a chain\n");
+		printf("    window <size>                  # random within windows of <size> bytes, windows in order\n");
+		printf("    zipf <theta>                   # random lines drawn with zipf skew <theta> >= 0\n");
+		printf("    trace <file>                   # lines in the order of the addresses in <file>\n");
 		printf("    forward <stride>               # chains are in forward order with constant stride\n");
 		printf("    reverse <stride>               # chains are in reverse order with constant stride\n");
 		printf("\n");
 		printf("Note: <stride> is always a small positive integer.\n");
+		printf("      random, forward and reverse chains are built in segments by\n");
+		printf("      --build-threads threads in the chain's domain; random-full is\n");
+		printf("      always built by a single thread.\n");
+		printf("      zipf chains draw once per line.  A line drawn more often than it\n");
+		printf("      has links continues in lines of an overflow area after the chain.\n");
+		printf("      trace chains are built by a single thread, hopping to the line of\n");
+		printf("      each address relative to the lowest one, and wrapping around at the\n");
+		printf("      end of the chain.  Repeated hops to the same line are skipped, as\n");
+		printf("      are hops to a line that has no free link left, which are counted on\n");
+		printf("      stderr.  zipf and trace chains rule out the *_line operations.\n");
+		printf("\n");
+		printf("<file> holds the magic \"pctrace1\" followed by little-endian 64-bit\n");
+		printf("addresses, or one hexadecimal address per line of text, like the output\n");
+		printf("of \"perf script -F addr\".  Blank lines and lines starting with # are skipped.\n");
+		printf("\n");
+		printf("Note: a chain file holds the geometry and layout options of the run that\n");
+		printf("saved it, which replace the line, page and chain sizes, threads, chains\n");
+		printf("per thread, access pattern, offset, split and seed of the command line.\n");
+		printf("Loading relocates the saved links into freshly allocated chains, so runs\n");
+		printf("on different hosts chase exactly the same sequence.\n");
+		printf("\n");
+		printf("<offset> is a number of bytes below the line size, or random for an\n");
+		printf("aligned offset drawn for every line that keeps the link within the line.\n");
+		printf("\n");
+		printf("<pages> is selected from the following:\n");
+		printf("    system                         # the kernel's transparent huge page policy (default)\n");
+		printf("    4k                             # small pages only (MADV_NOHUGEPAGE)\n");
+		printf("    thp                            # transparent huge pages (MADV_HUGEPAGE)\n");
+		printf("    2m                             # 2 MB hugetlbfs pages (MAP_HUGETLB)\n");
+		printf("    1g                             # 1 GB hugetlbfs pages (MAP_HUGETLB)\n");
+		printf("\n");
+		printf("Note: the results report the size of the pages actually backing the chains.\n");
+		printf("hugetlbfs pages that are not available fall back to transparent huge pages,\n");
+		printf("or fail with --strict.  The page size of -p only shapes the random layout.\n");
+		printf("\n");
+		printf("<prefault> is selected from the following:\n");
+		printf("    none                           # pages fault in while the chains are built (default)\n");
+		printf("    populate                       # the kernel faults in all pages (MADV_POPULATE_WRITE)\n");
+		printf("    touch                          # --build-threads threads in the domain touch the pages\n");
+		printf("\n");
+		printf("Note: each chain is mapped and bound to its numa domain with mbind, so it is\n");
+		printf("placed there whichever thread touches it.  The results report the share of\n");
+		printf("the resident pages found in the intended domain by move_pages.  Memory that\n");
+		printf("cannot be locked fails with --strict, and is used unlocked otherwise.\n");
+		printf("\n");
+		printf("<backing> is selected from the following:\n");
+		printf("    anon                           # anonymous memory (default)\n");
+		printf("    file:<path>                    # a new file at <path>, on tmpfs, a disk or a DAX mount\n");
+		printf("\n");
+		printf("Note: the backing file must not exist yet.  It holds a slot for every chain,\n");
+		printf("mapped shared so the chains live in its page cache, and is removed as soon\n");
+		printf("as it is created, so it goes away with the process.  --cold writes the\n");
+		printf("chains back and drops them from memory (MADV_PAGEOUT, POSIX_FADV_DONTNEED)\n");
+		printf("before each experiment, so the experiment measures faulting them in again;\n");
+		printf("anonymous and tmpfs memory is only paged out where there is swap.  Only\n");
+		printf("the first pass of an experiment is cold, so use -i 1 for fault latencies.\n");
+		printf("\n");
+		printf("<boundary> is selected from the following:\n");
+		printf("    line                           # the next pointer straddles two cache lines\n");
+		printf("    page                           # the next pointer straddles two pages\n");
+		printf("\n");
+		printf("Note: a page split chases one link per page, across the end of its last line.\n");
+		printf("Misaligned links rule out the atomic, acquire and release operations,\n");
+		printf("any offset rules out zero_line and store_line_nt, and random offsets rule out\n");
+		printf("store_all and store_line.\n");
+		printf("\n");
+		printf("<kernel> is selected from the following:\n");
+		printf("    jit                            # code generated at run time (default)\n");
+		printf("    native                         # compiled C++ code (the only choice without asmjit)\n");
+		printf("    stream-copy                    # STREAM copy, b = a\n");
+		printf("    stream-scale                   # STREAM scale, b = q * a\n");
+		printf("    stream-add                     # STREAM add, c = a + b\n");
+		printf("    stream-triad                   # STREAM triad, a = b + q * c\n");
+		printf("    fault                          # first touch of freshly mapped chain memory\n");
+		printf("\n");
+		printf("Note: the STREAM kernels use the chains of each thread as the arrays, two for\n");
+		printf("copy and scale and three for add and triad, so -r is ignored and the arrays\n");
+		printf("follow the numa placement of the chains.  Bandwidth counts the bytes read and\n");
+		printf("written like STREAM does, and latency is the time per element.\n");
+		printf("\n");
+		printf("Note: the fault kernel maps the chains of each thread afresh for every\n");
+		printf("experiment, with the pages and numa placement of the experiment, and times\n");
+		printf("writing the first byte of each page.  It sweeps the threads faulting at once\n");
+		printf("from 1 to -t, reporting the page faults per second, the bandwidth of the\n");
+		printf("memory faulted in, and the speedup over a single thread.  With a backing\n");
+		printf("file, every experiment faults in pages allocated afresh in punched holes of\n");
+		printf("the file, or with --cold pages written back and dropped from the page cache.\n");
+		printf("\n");
+		printf("Note: native supports up to %d chains per thread, unroll factors 1, 2, 4 and 8,\n", NATIVE_MAX_CHAINS);
+		printf("and the operations none, load, store, load_all, store_all, load_line and store_line.\n");
+		printf("\n");
+		printf("<work> is selected from the following:\n");
+		printf("    nop                            # no operation (default)\n");
+		printf("    dep                            # a chain of dependent integer additions\n");
+		printf("    indep                          # four interleaved chains of integer additions\n");
+		printf("    fma                            # a chain of dependent floating point multiply-adds\n");
+		printf("\n");
+		printf("Note: the work is repeated <number> times per iteration, and fma is jit only.\n");
+		printf("\n");
+		printf("<operation> is selected from the following:\n");
+		printf("    none                           # only chase the pointers\n");
+		printf("    load                           # load one word of each link\n");
+		printf("    store                          # store one word of each link\n");
+		printf("    load_all                       # load one word of <stride> lines per link\n");
+		printf("    store_all                      # store one word of <stride> lines per link\n");
+		printf("    load_line                      # load every byte of <stride> lines per link (vector)\n");
+		printf("    store_line                     # store every byte of <stride> lines per link (vector)\n");
+		printf("    store_nt                       # non-temporal store of one word of each link\n");
+		printf("    store_line_nt                  # non-temporal store of every byte of <stride> lines per link\n");
+		printf("    zero_line                      # zero <stride> lines per link without reading them (arm only)\n");
+		printf("    flush                          # load one word of each link, then flush its lines to memory\n");
+		printf("    atomic_add                     # atomically add to one word of each link\n");
+		printf("    cas                            # atomically compare and swap one word of each link\n");
+		printf("    swap                           # atomically swap one word of each link\n");
+		printf("    load_acquire                   # chase with load-acquire (LDAR)\n");
+		printf("    load_acquire_pc                # chase with processor consistent load-acquire (LDAPR)\n");
+		printf("    store_release                  # store-release (STLR) of one word of each link\n");
+		printf("    fence                          # full barrier (DMB ISH) after each link\n");
+		printf("    fence_load                     # load barrier (DMB ISHLD) after each link\n");
+		printf("    mix:<percent>                  # load one word of <percent> of the links, store the rest\n");
+		printf("\n");
+		printf("<order> is selected from the following:\n");
+		printf("    relaxed                        # no ordering (default)\n");
+		printf("    acquire                        # acquire semantics\n");
+		printf("    release                        # release semantics\n");
+		printf("    acq_rel                        # acquire and release semantics\n");
+		printf("\n");
+		printf("Note: atomics use the LSE instructions on arm, and always order fully on x86.\n");
+		printf("      On x86, acquire loads and release stores are plain moves, and the\n");
+		printf("      barriers are MFENCE and LFENCE.\n");
+		printf("      mix repeats after 100 / gcd(<percent>, 100) hops, and rounds the unroll\n");
+		printf("      up to a multiple of that.\n");
 		printf("\n");
 		printf("<format> is selected from the following:\n");
 		printf("    hdr                            # csv header only\n");
@@ -449,6 +989,9 @@ int Experiment::parse_args(int argc, char* argv[]) {
 		printf("    t1                             # use the T1 hint (prefetch into all caches except L1)\n");
 		printf("    t2                             # use the T2 hint (prefetch into all caches except L1 & L2)\n");
 		printf("\n");
+		printf("Note: on arm, the hints map to PLDL1KEEP, PLDL2KEEP, PLDL3KEEP and PLDL1STRM,\n");
+		printf("and the link prefetched is the one <number> hops ahead in the chain.\n");
+		printf("\n");
 		printf("<placement> is selected from the following:\n");
 		printf("    local                          # all chains are allocated locally\n");
 		printf("    xor <mask>                     # exclusive OR and mask\n");
@@ -466,18 +1009,68 @@ int Experiment::parse_args(int argc, char* argv[]) {
 		printf("thread or chain domains that exceed the maximum NUMA domain\n");
 		printf("are wrapped around using a MOD function.\n");
 		printf("\n");
+		printf("The --mlp sweep builds the chains once and chases the first 1, 2, ...\n");
+		printf("of them in turn.  For each step it reports the latency of a reference,\n");
+		printf("the bandwidth and, by Little's law, the misses outstanding per thread:\n");
+		printf("the references completed per second times the latency of a single chain.\n");
+		printf("\n");
 		printf("To determine the number of NUMA domains currently available\n");
 		printf("on your system, use a command such as \"numastat\".\n");
 		printf("\n");
 		printf("Final note: strict is not yet fully implemented, and\n");
 		printf("maps do not gracefully handle ill-formed map specifications.\n");
 
-		return 1;
+		return -1;
 	}
 
 
 	// STRICT -- fail if specifications are inconsistent
 
+	// a chain file brings its own geometry
+	if (this->load_file != NULL) {
+		this->layout = new Layout();
+		if (this->layout->load(this->load_file) != 0) {
+			return 1;
+		}
+		this->layout->apply(*this);
+	}
+	if ((this->load_file != NULL || this->save_file != NULL) && this->is_stream()) {
+		printf("chase: the STREAM kernels have no chain layouts to save or load\n");
+		return 1;
+	}
+
+	// the fault kernel maps its memory itself
+	if (this->kernel == FAULT) {
+		if (this->mlp || this->load_file != NULL || this->save_file != NULL) {
+			printf("chase: the fault kernel has no chains to sweep, save or load\n");
+			return 1;
+		}
+		if (this->prefault != NO_PREFAULT || this->lock_memory) {
+			printf("chase: the fault kernel cannot prefault or lock its memory\n");
+			return 1;
+		}
+	}
+
+	// the STREAM kernels work on one array per chain
+	if (this->is_stream()) {
+		if (this->mlp) {
+			printf("chase: the STREAM kernels cannot sweep the chains per thread\n");
+			return 1;
+		}
+		this->chains_per_thread = this->stream_arrays();
+	}
+
+	// a link carries its lookahead only
+	// when the experiment prefetches
+	if (this->prefetch_hint != NONE) {
+		this->pointer_size = sizeof(Lookahead);
+	}
+	if (this->bytes_per_line < this->pointer_size) {
+		printf("chase: lines of %lld bytes cannot hold links of %lld bytes\n",
+				this->bytes_per_line, this->pointer_size);
+		return 1;
+	}
+
 	// compute lines per page and lines per chain
 	// based on input and defaults.
 	// we round up page and chain sizes when needed.
@@ -492,6 +1085,13 @@ int Experiment::parse_args(int argc, char* argv[]) {
 	this->lines_per_chain  = this->lines_per_page * this->pages_per_chain;
 	this->links_per_chain  = this->lines_per_chain * this->links_per_line;
 
+	// a page split chases one link per page, in its
+	// last line, and keeps the line size moved by
+	// the operations
+	if (this->split == PAGE) {
+		this->lines_per_page   = 1;
+		this->lines_per_chain  = this->pages_per_chain;
+	}
 
 	// allocate the chain roots for all threads
 	// and compute the chain locations
@@ -502,15 +1102,9 @@ int Experiment::parse_args(int argc, char* argv[]) {
 	case ADD:
 		this->thread_domain = new int32[this->num_threads];
 		this->chain_domain = new int32*[this->num_threads];
-		this->random_state = new char*[this->num_threads];
 
 		for (int i = 0; i < this->num_threads; i++) {
 			this->chain_domain[i] = new int32[this->chains_per_thread];
-
-			const int state_size = 256;
-			this->random_state[i] = new char[state_size];
-			initstate((unsigned int) i, (char *) this->random_state[i],
-					(size_t) state_size);
 		}
 		break;
 	}
@@ -536,6 +1130,148 @@ int Experiment::parse_args(int argc, char* argv[]) {
 		break;
 	}
 
+	// a map sets its own number of chains,
+	// which must hold the STREAM arrays
+	if (this->is_stream() && this->chains_per_thread < this->stream_arrays()) {
+		printf("chase: the %s kernel needs %lld chains per thread in the numa map\n",
+				kernel_string(this->kernel), this->stream_arrays());
+		return 1;
+	}
+
+	// the next pointer straddles the boundary
+	// at the end of the line, half on each side
+	if (this->split != UNSPLIT) {
+		this->link_offset = this->line_stride() - sizeof(Chain*) / 2;
+		this->random_offset = false;
+	}
+	if (this->line_stride() <= this->link_offset) {
+		printf("chase: link offset must be below the line size\n");
+		return 1;
+	}
+	if (this->is_misaligned() && (this->is_atomic()
+			|| this->mem_operation == LOAD_ACQUIRE
+			|| this->mem_operation == LOAD_ACQUIRE_PC
+			|| this->mem_operation == STORE_RELEASE)) {
+		printf("chase: the %s operation needs aligned links\n", operation_string(this->mem_operation));
+		return 1;
+	}
+	if ((this->link_offset != 0 || this->random_offset)
+			&& (this->mem_operation == ZERO_LINE || this->mem_operation == STORE_LINE_NT)) {
+		printf("chase: the %s operation needs links at the start of their lines\n", operation_string(this->mem_operation));
+		return 1;
+	}
+	if (this->random_offset
+			&& (this->mem_operation == STORE_ALL || this->mem_operation == STORE_LINE)) {
+		// the stores would land on the links of the following lines
+		printf("chase: the %s operation needs the same offset in every line\n", operation_string(this->mem_operation));
+		return 1;
+	}
+	if ((this->access_pattern == ZIPF || this->access_pattern == TRACE) && this->is_line_wide()) {
+		// the line holds the links of all its visits
+		printf("chase: the %s operation does not support the %s access pattern\n",
+				operation_string(this->mem_operation), this->access());
+		return 1;
+	}
+
+	// the trace must fit the chain, or
+	// its addresses wrap around
+	if (this->access_pattern == TRACE && this->layout == NULL) {
+		this->trace = new Trace();
+		if (this->trace->load(this->trace_file) != 0) {
+			return 1;
+		}
+		if (this->strict && (uint64) this->bytes_per_chain < this->trace->span()) {
+			printf("chase: trace spans %llu bytes, more than the chain size\n", this->trace->span());
+			return 1;
+		}
+	}
+
+	// the pages must be available to
+	// back all chains of the test
+	if (this->strict && this->pages == TRANSPARENT_HUGE_PAGES && !Memory::thp_enabled()) {
+		printf("chase: transparent huge pages are not enabled\n");
+		return 1;
+	}
+	if (this->strict && (this->pages == HUGE_PAGES_2M || this->pages == HUGE_PAGES_1G)) {
+		int64 size = Memory::huge_page_size(this->pages);
+		int64 needed = this->num_threads * this->chains_per_thread
+				* ((this->bytes_per_region() + size - 1) / size);
+		int64 available = Memory::free_huge_pages(size);
+		if (available < needed) {
+			printf("chase: %lld free %s pages, %lld needed\n", available, pages_string(this->pages), needed);
+			return 1;
+		}
+	}
+
+	// the chains get their slots of the backing
+	// file, which hugetlbfs pages cannot back
+	if (this->backing_file != NULL) {
+		if (this->pages == HUGE_PAGES_2M || this->pages == HUGE_PAGES_1G) {
+			printf("chase: %s pages need anonymous backing\n", pages_string(this->pages));
+			return 1;
+		}
+		if (Memory::create_file(*this) != 0) {
+			return 1;
+		}
+	}
+
+	// the saved links must lie within the chains,
+	// and a numa map must keep their number
+	if (this->layout != NULL) {
+		if (this->layout->link_size() != this->pointer_size) {
+			printf("chase: chain file '%s' has links of %lld bytes, not %lld\n",
+					this->load_file, this->layout->link_size(), this->pointer_size);
+			return 1;
+		}
+		if (!this->layout->fits(this->num_threads, this->chains_per_thread,
+				this->bytes_per_region())) {
+			printf("chase: chain file '%s' does not fit the chains of the experiment\n", this->load_file);
+			return 1;
+		}
+	}
+
+	// windows hold whole lines, and
+	// at most the whole chain
+	if (this->access_pattern == WINDOW) {
+		this->window = (this->window + this->line_stride() - 1) / this->line_stride() * this->line_stride();
+		this->window = std::min(this->window, this->bytes_per_chain);
+	}
+
+	// the mix repeats after a fixed number of hops,
+	// so every chain loads and stores at the same
+	// place in each pass of the unrolled loop
+	if (this->mem_operation == MIX) {
+		int64 period = this->mix_period();
+		if (this->unroll % period != 0) {
+			if (this->strict) {
+				printf("chase: unroll must be a multiple of %lld for mix:%lld\n", period, this->read_percent);
+				return 1;
+			}
+			this->unroll = (this->unroll + period - 1) / period * period;
+		}
+	}
+
+	// the native kernel is only compiled for a
+	// limited range of chains and unroll factors
+	if (this->kernel == NATIVE) {
+		if (!native_supports(this->mem_operation)) {
+			printf("chase: native kernel does not support the %s operation\n", operation_string(this->mem_operation));
+			return 1;
+		}
+		if (this->work == FMA) {
+			printf("chase: native kernel does not support the fma work\n");
+			return 1;
+		}
+		if (NATIVE_MAX_CHAINS < this->chains_per_thread) {
+			printf("chase: native kernel supports at most %d chains per thread\n", NATIVE_MAX_CHAINS);
+			return 1;
+		}
+		if (NATIVE_MAX_UNROLL < this->unroll || (this->unroll & (this->unroll - 1)) != 0) {
+			printf("chase: native kernel supports unroll factors 1, 2, 4 and 8 only\n");
+			return 1;
+		}
+	}
+
 	return 0;
 }
 
@@ -702,16 +1438,10 @@ void Experiment::alloc_map() {
 
 	this->thread_domain = new int32[this->num_threads];
 	this->chain_domain = new int32*[this->num_threads];
-	this->random_state = new char*[this->num_threads];
 
 	for (int i = 0; i < this->num_threads; i++) {
 		this->thread_domain[i] = thread_domain[i] % this->num_numa_domains;
 
-		const int state_size = 256;
-		this->random_state[i] = new char[state_size];
-		initstate((unsigned int) i, (char *) this->random_state[i],
-				(size_t) state_size);
-
 		this->chain_domain[i] = new int32[this->chains_per_thread];
 		for (int j = 0; j < this->chains_per_thread; j++) {
 			this->chain_domain[i][j] = chain_domain[i][j]
@@ -724,11 +1454,126 @@ void Experiment::alloc_map() {
 }
 
 
+int64 Experiment::lines_per_op() {
+	switch (this->mem_operation) {
+	case LOAD_ALL:
+	case STORE_ALL:
+	case LOAD_LINE:
+	case STORE_LINE:
+	case STORE_LINE_NT:
+	case ZERO_LINE:
+		return this->stride < 0 ? -this->stride : this->stride;
+	default:
+		break;
+	}
+
+	return 1;
+}
+
+// a whole line moves through the memory
+// hierarchy for every line touched
+int64 Experiment::bytes_per_op() {
+	// the STREAM kernels count one operation per element
+	if (this->is_stream())
+		return sizeof(double);
+	return this->lines_per_op() * this->bytes_per_line;
+}
+
+// hops each chain chases in the iterations. the
+// kernels chase whole unrolled passes, so the hops
+// round up to a multiple of the unroll factor,
+// which the mix raises to its period
+int64 Experiment::hops(int64 ops, int64 iterations) {
+	int64 links = ops * iterations;
+	if (this->is_stream())
+		return links;
+	return (links + this->unroll - 1) / this->unroll * this->unroll;
+}
+
+bool Experiment::is_stream() {
+	return this->kernel == STREAM_COPY || this->kernel == STREAM_SCALE
+		|| this->kernel == STREAM_ADD || this->kernel == STREAM_TRIAD;
+}
+
+int64 Experiment::stream_arrays() {
+	if (this->kernel == STREAM_ADD || this->kernel == STREAM_TRIAD)
+		return 3;
+	return 2;
+}
+
+static int64 gcd(int64 a, int64 b) {
+	while (b != 0) {
+		int64 t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+int64 Experiment::mix_period() {
+	return 100 / gcd(this->read_percent, 100);
+}
+
+// spread the loads evenly over the period,
+// so mix:75 stores one hop in every four
+bool Experiment::mix_loads(int64 hop) {
+	int64 h = hop % this->mix_period();
+	return (h + 1) * this->read_percent / 100 != h * this->read_percent / 100;
+}
+
+// bytes mapped for each chain: the chain, a spare
+// line for the links across its end and, for zipf,
+// an overflow area as large as the chain
+int64 Experiment::bytes_per_region() {
+	int64 bytes = this->bytes_per_chain + this->bytes_per_line;
+	if (this->access_pattern == ZIPF) {
+		bytes += this->bytes_per_chain;
+	}
+	return bytes;
+}
+
+// bytes from one line of the chains to the
+// next, the whole page for a page split
+int64 Experiment::line_stride() {
+	return this->bytes_per_page / this->lines_per_page;
+}
+
+bool Experiment::is_misaligned() {
+	return this->link_offset % sizeof(Chain*) != 0;
+}
+
+// the fields of the link run from its line into
+// the next one, as with a split or a large offset
+bool Experiment::link_crosses_line() {
+	return !this->random_offset
+			&& this->bytes_per_line < this->link_offset % this->bytes_per_line + this->pointer_size;
+}
+
+// the operation moves the whole line,
+// not only the link it hops to
+bool Experiment::is_line_wide() {
+	return this->mem_operation == LOAD_LINE || this->mem_operation == STORE_LINE
+		|| this->mem_operation == STORE_LINE_NT || this->mem_operation == ZERO_LINE;
+}
+
+bool Experiment::is_atomic() {
+	return this->mem_operation == ATOMIC_ADD || this->mem_operation == CAS
+		|| this->mem_operation == SWAP;
+}
+
 const char* Experiment::access() {
 	const char* result = NULL;
 
 	if (this->access_pattern == RANDOM) {
 		result = "random";
+	} else if (this->access_pattern == RANDOM_FULL) {
+		result = "random-full";
+	} else if (this->access_pattern == WINDOW) {
+		result = "window";
+	} else if (this->access_pattern == ZIPF) {
+		result = "zipf";
+	} else if (this->access_pattern == TRACE) {
+		result = "trace";
 	} else if (this->access_pattern == STRIDED && 0 < this->stride) {
 		result = "forward";
 	} else if (this->access_pattern == STRIDED && this->stride < 0) {
@@ -22,6 +22,8 @@
 #include "chain.h"
 #include "types.h"
 
+class Trace;
+class Layout;
 
 //
 // Class definition
@@ -32,15 +34,28 @@ public:
 	Experiment();
 	~Experiment();
 
-	int parse_args(int argc, char* argv[]);
+	int parse_args(int argc, char* argv[]);	// 1 on errors, -1 after the usage
 	int64 parse_number(const char* s);
 	float parse_real(const char* s);
 
 	const char* placement();
 	const char* access();
+	int64 lines_per_op();	// lines touched by each memory operation
+	int64 bytes_per_op();	// bytes moved by each memory operation
+	int64 hops(int64 ops, int64 iterations);	// hops chased per chain
+	bool is_atomic();		// memory operation is a read-modify-write
+	int64 mix_period();		// hops after which the mix repeats
+	bool mix_loads(int64 hop);	// hop of the mix period loads, or stores
+	bool is_stream();		// kernel is one of STREAM, not a pointer chase
+	int64 stream_arrays();	// arrays (chains) the STREAM kernel works on
+	int64 bytes_per_region();	// bytes mapped for each chain
+	int64 line_stride();	// bytes between the lines of the chains
+	bool is_misaligned();	// links are not naturally aligned
+	bool is_line_wide();	// memory operation moves whole lines
+	bool link_crosses_line();	// link straddles the end of its line
 
 	// fundamental parameters
-    int64 pointer_size;		// number of bytes in a pointer
+    int64 pointer_size;		// number of bytes in a link
     int64 bytes_per_line;	// working set cache line size (bytes)
     int64 links_per_line;	// working set cache line size (links)
     int64 bytes_per_page;	// working set page size (in bytes)
@@ -52,9 +67,11 @@ public:
     int64 pages_per_chain;	// working set chain size (pages)
     int64 bytes_per_thread;	// thread working set size (bytes)
     int64 chains_per_thread;// memory loading per thread
+    bool mlp;				// sweep the chains chased from 1 to chains_per_thread
     int64 num_threads;		// number of threads in the experiment
     int64 bytes_per_test;	// test working set size (bytes)
-    int64 loop_length;		// length of the inner loop (cycles)
+    int64 loop_length;		// length of the inner loop (instructions)
+    int64 unroll;			// links chased per end-of-loop test
 
     float seconds;			// number of seconds per experiment
     int64 iterations;		// number of iterations per experiment
@@ -62,16 +79,50 @@ public:
 
     enum { NONE, T0, T1, T2, NTA }
     prefetch_hint;			// use of prefetching
+    int64 prefetch_distance;// number of links to prefetch ahead
 
-    enum { NA, LOAD, STORE, LOAD_ALL, STORE_ALL }
+    enum { NA, LOAD, STORE, LOAD_ALL, STORE_ALL, LOAD_LINE, STORE_LINE,
+           STORE_NT, STORE_LINE_NT, ZERO_LINE, FLUSH, ATOMIC_ADD, CAS, SWAP,
+           LOAD_ACQUIRE, LOAD_ACQUIRE_PC, STORE_RELEASE, FENCE, FENCE_LOAD, MIX }
 	mem_operation;			// memory operation
+    int64 read_percent;		// loads among the hops of the mix operation
+
+    enum { RELAXED, ACQUIRE, RELEASE, ACQ_REL }
+	memory_order;			// ordering of atomic operations
 
     enum { CSV, BOTH, HEADER, TABLE }
 	output_mode;			// results output mode
 
-    enum { RANDOM, STRIDED }
+    enum { JIT, NATIVE, STREAM_COPY, STREAM_SCALE, STREAM_ADD, STREAM_TRIAD, FAULT }
+	kernel;					// benchmark code generation
+
+    enum { NOP, DEPENDENT, INDEPENDENT, FMA }
+	work;					// instructions of the inner loop
+
+    enum { RANDOM, STRIDED, RANDOM_FULL, WINDOW, ZIPF, TRACE }
 	access_pattern;			// memory access pattern
     int64 stride;
+    int64 window;			// window of the windowed pattern (bytes)
+    float zipf_theta;		// skew of the zipf pattern
+    char* trace_file;		// file of the trace pattern
+    Trace* trace;			// addresses of the trace pattern
+    int64 link_offset;		// offset of the links in their lines (bytes)
+    bool random_offset;		// offset drawn for every line instead
+
+    enum { UNSPLIT, LINE, PAGE }
+	split;					// boundary the next pointer straddles
+
+    enum { SYSTEM_PAGES, SMALL_PAGES, TRANSPARENT_HUGE_PAGES, HUGE_PAGES_2M, HUGE_PAGES_1G }
+	pages;					// pages backing the chains
+    int64 backing_page_size;// size of the pages obtained (bytes)
+    enum { NO_PREFAULT, POPULATE, TOUCH }
+	prefault;				// faulting in the chains before building them
+    bool lock_memory;		// lock the chains in memory
+    char* backing_file;		// file backing the chains, or NULL for anonymous memory
+    int backing_fd;			// descriptor of the backing file
+    bool cold;				// evict the chains before each experiment
+    int64 pages_placed;		// pages of the chains in their numa domain
+    int64 pages_resident;	// pages of the chains in memory
 
     enum { LOCAL, XOR, ADD, MAP }
 	numa_placement;			// memory allocation mode
@@ -84,7 +135,11 @@ public:
     int32 numa_max_domain;	// highest numa domain id
     int32 num_numa_domains;	// number of numa domains
 
-    char** random_state;	// random state for each thread
+    uint64 seed;			// seed of the chain layouts
+    int64 build_threads;	// threads building each chain
+    char* save_file;		// file the chain layouts are saved to
+    char* load_file;		// file the chain layouts are loaded from
+    Layout* layout;			// chain layouts loaded from load_file
 
     bool strict;			// strictly adhere to user input, or fail
 
@@ -103,6 +158,8 @@ public:
     const static int32 DEFAULT_THREADS           = 1;
     const static int32 DEFAULT_BYTES_PER_TEST    = DEFAULT_BYTES_PER_THREAD * DEFAULT_THREADS;
     const static int32 DEFAULT_LOOPLENGTH        = 0;
+    const static int32 DEFAULT_UNROLL            = 1;
+    const static int32 DEFAULT_PREFETCH_DISTANCE = 1;
     const static int32 DEFAULT_SECONDS           = 1;
     const static int32 DEFAULT_ITERATIONS        = 0;
     const static int32 DEFAULT_EXPERIMENTS       = 1;
@@ -131,6 +188,84 @@ inline const char* prefetch_hint_string(int32 prefetch_hint) {
     return "none";
 }
 
+inline const char* kernel_string(int32 kernel) {
+	switch (kernel) {
+	case Experiment::JIT:
+		return "jit";
+	case Experiment::NATIVE:
+		return "native";
+	case Experiment::STREAM_COPY:
+		return "stream-copy";
+	case Experiment::STREAM_SCALE:
+		return "stream-scale";
+	case Experiment::STREAM_ADD:
+		return "stream-add";
+	case Experiment::STREAM_TRIAD:
+		return "stream-triad";
+	case Experiment::FAULT:
+		return "fault";
+	}
+    return "none";
+}
+
+inline const char* work_string(int32 work) {
+	switch (work) {
+	case Experiment::DEPENDENT:
+		return "dep";
+	case Experiment::INDEPENDENT:
+		return "indep";
+	case Experiment::FMA:
+		return "fma";
+	}
+    return "nop";
+}
+
+inline const char* split_string(int32 split) {
+	switch (split) {
+	case Experiment::LINE:
+		return "line";
+	case Experiment::PAGE:
+		return "page";
+	}
+    return "none";
+}
+
+inline const char* pages_string(int32 pages) {
+	switch (pages) {
+	case Experiment::SMALL_PAGES:
+		return "4k";
+	case Experiment::TRANSPARENT_HUGE_PAGES:
+		return "thp";
+	case Experiment::HUGE_PAGES_2M:
+		return "2m";
+	case Experiment::HUGE_PAGES_1G:
+		return "1g";
+	}
+    return "system";
+}
+
+inline const char* prefault_string(int32 prefault) {
+	switch (prefault) {
+	case Experiment::POPULATE:
+		return "populate";
+	case Experiment::TOUCH:
+		return "touch";
+	}
+    return "none";
+}
+
+inline const char* memory_order_string(int32 order) {
+	switch (order) {
+	case Experiment::ACQUIRE:
+		return "acquire";
+	case Experiment::RELEASE:
+		return "release";
+	case Experiment::ACQ_REL:
+		return "acq_rel";
+	}
+    return "relaxed";
+}
+
 inline const char* operation_string(int32 operation) {
 	switch (operation) {
 	case Experiment::LOAD:
@@ -141,6 +276,36 @@ inline const char* operation_string(int32 operation) {
 		return "load_all";
 	case Experiment::STORE_ALL:
 		return "store_all";
+	case Experiment::LOAD_LINE:
+		return "load_line";
+	case Experiment::STORE_LINE:
+		return "store_line";
+	case Experiment::STORE_NT:
+		return "store_nt";
+	case Experiment::STORE_LINE_NT:
+		return "store_line_nt";
+	case Experiment::ZERO_LINE:
+		return "zero_line";
+	case Experiment::FLUSH:
+		return "flush";
+	case Experiment::ATOMIC_ADD:
+		return "atomic_add";
+	case Experiment::CAS:
+		return "cas";
+	case Experiment::SWAP:
+		return "swap";
+	case Experiment::LOAD_ACQUIRE:
+		return "load_acquire";
+	case Experiment::LOAD_ACQUIRE_PC:
+		return "load_acquire_pc";
+	case Experiment::STORE_RELEASE:
+		return "store_release";
+	case Experiment::FENCE:
+		return "fence";
+	case Experiment::FENCE_LOAD:
+		return "fence_load";
+	case Experiment::MIX:
+		return "mix";
 	}
     return "none";
 }
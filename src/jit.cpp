@@ -0,0 +1,47 @@
+/*******************************************************************************
+ * Copyright (c) 2006 International Business Machines Corporation.             *
+ * All rights reserved. This program and the accompanying materials            *
+ * are made available under the terms of the Common Public License v1.0        *
+ * which accompanies this distribution, and is available at                    *
+ * http://www.opensource.org/licenses/cpl1.0.php                               *
+ *                                                                             *
+ * Contributors:                                                               *
+ *    Douglas M. Pase - initial API and implementation                         *
+ *    Tim Besard - prefetching, JIT compilation                                *
+ *******************************************************************************/
+
+//
+// Configuration
+//
+
+// Implementation header
+#include "jit.h"
+
+// System includes
+#include <cstdio>
+
+
+//
+// Implementation
+//
+
+// the code generator is selected from the architecture
+// of the host, as reported by the JIT runtime, so the
+// same binary chases pointers on both arm and x86 nodes.
+benchmark chase_pointers(asmjit::JitRuntime &rt, Experiment &exp) {
+	switch (rt.environment().arch()) {
+#if !defined(ASMJIT_NO_AARCH64)
+	case asmjit::Arch::kAArch64:
+		return chase_pointers_a64(rt, exp);
+#endif
+#if !defined(ASMJIT_NO_X86)
+	case asmjit::Arch::kX64:
+		return chase_pointers_x86(rt, exp);
+#endif
+	default:
+		break;
+	}
+
+	printf("Error making jit function (unsupported architecture).\n");
+	return 0;
+}
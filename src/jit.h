@@ -0,0 +1,40 @@
+/*******************************************************************************
+ * Copyright (c) 2006 International Business Machines Corporation.             *
+ * All rights reserved. This program and the accompanying materials            *
+ * are made available under the terms of the Common Public License v1.0        *
+ * which accompanies this distribution, and is available at                    *
+ * http://www.opensource.org/licenses/cpl1.0.php                               *
+ *                                                                             *
+ * Contributors:                                                               *
+ *    Douglas M. Pase - initial API and implementation                         *
+ *    Tim Besard - prefetching, JIT compilation                                *
+ *******************************************************************************/
+
+//
+// Configuration
+//
+
+// Include guard
+#if !defined(JIT_H)
+#define JIT_H
+
+// System includes
+#include <asmjit/core.h>
+
+// Local includes
+#include "kernel.h"
+#include "experiment.h"
+
+
+//
+// Function definitions
+//
+
+// generate the benchmark for the architecture of the host
+benchmark chase_pointers(asmjit::JitRuntime &rt, Experiment &exp);
+
+// architecture specific code generators
+benchmark chase_pointers_a64(asmjit::JitRuntime &rt, Experiment &exp);
+benchmark chase_pointers_x86(asmjit::JitRuntime &rt, Experiment &exp);
+
+#endif
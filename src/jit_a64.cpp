@@ -0,0 +1,441 @@
+/*******************************************************************************
+ * Copyright (c) 2006 International Business Machines Corporation.             *
+ * All rights reserved. This program and the accompanying materials            *
+ * are made available under the terms of the Common Public License v1.0        *
+ * which accompanies this distribution, and is available at                    *
+ * http://www.opensource.org/licenses/cpl1.0.php                               *
+ *                                                                             *
+ * Contributors:                                                               *
+ *    Douglas M. Pase - initial API and implementation                         *
+ *    Tim Besard - prefetching, JIT compilation                                *
+ *******************************************************************************/
+
+//
+// Configuration
+//
+
+// Implementation header
+#include "jit.h"
+
+// System includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <vector>
+
+// Local includes
+#include <asmjit/a64.h>
+
+
+//
+// Implementation
+//
+
+using namespace asmjit;
+using namespace asmjit::a64;
+
+// PRFM operations, encoded as <type><target><policy>
+static const uint32_t PLDL1KEEP = 0x00;
+static const uint32_t PLDL1STRM = 0x01;
+static const uint32_t PLDL2KEEP = 0x02;
+static const uint32_t PLDL3KEEP = 0x04;
+
+// bytes moved by a single vector (Q register) access
+static const int64 VEC_BYTES = 16;
+// largest offset of a load or store pair of Q registers
+static const int64 PAIR_OFFSET_MAX = 1008;
+// vector registers loads rotate through
+static const int VEC_LOADS = 4;
+// interleaved chains of independent work
+static const int WORK_CHAINS = 4;
+
+// registers shared by the operations on all links
+struct Registers {
+	std::vector<Gp> vals;	// scalar values loaded or stored
+	std::vector<Vec> vecs;	// vector values loaded or stored
+	Vec copy;				// vector holding a chunk of the link itself
+	Vec pair;				// vector holding the next chunk of the link
+	Gp next, ahead;			// link header saved while its line is zeroed
+	Gp addr;				// scratch address
+	int64 zva_bytes;		// bytes zeroed by a single DC ZVA
+	std::vector<Gp> work;	// integer work accumulators
+	Vec acc, mul;			// floating point work accumulator and factor
+};
+
+// address position + offset, through the scratch
+// register when the offset is out of range
+static Mem pair_ptr(Compiler &c, const Gp &position, int64 offset, Registers &r) {
+	if (offset <= PAIR_OFFSET_MAX)
+		return ptr(position, offset);
+
+	c.mov(r.addr, offset);
+	c.add(r.addr, r.addr, position);
+	return ptr(r.addr);
+}
+
+// bytes zeroed by DC ZVA on this host, or 0 if prohibited
+static int64 zva_block_size() {
+#if defined(__aarch64__)
+	uint64_t dczid;
+	__asm__ __volatile__("mrs %0, dczid_el0" : "=r"(dczid));
+	if (dczid & 0x10)
+		return 0;
+	return 4 << (dczid & 0xf);
+#else
+	return 0;
+#endif
+}
+
+// atomically update the data of the link at r.addr,
+// with the ordering semantics of the experiment
+static void emit_atomic(Compiler &c, Experiment &exp, Registers &r) {
+	const Mem m = ptr(r.addr);
+
+	switch (exp.mem_operation) {
+	case Experiment::ATOMIC_ADD:
+		// old value in vals[1]
+		switch (exp.memory_order) {
+		case Experiment::ACQUIRE: c.ldadda(r.vals[0], r.vals[1], m); break;
+		case Experiment::RELEASE: c.ldaddl(r.vals[0], r.vals[1], m); break;
+		case Experiment::ACQ_REL: c.ldaddal(r.vals[0], r.vals[1], m); break;
+		default: c.ldadd(r.vals[0], r.vals[1], m); break;
+		}
+		break;
+	case Experiment::CAS:
+		// data is zero, so comparing with zero always
+		// succeeds and the old value stays zero
+		switch (exp.memory_order) {
+		case Experiment::ACQUIRE: c.casa(r.vals[1], r.vals[2], m); break;
+		case Experiment::RELEASE: c.casl(r.vals[1], r.vals[2], m); break;
+		case Experiment::ACQ_REL: c.casal(r.vals[1], r.vals[2], m); break;
+		default: c.cas(r.vals[1], r.vals[2], m); break;
+		}
+		break;
+	case Experiment::SWAP:
+		// old value in vals[1]
+		switch (exp.memory_order) {
+		case Experiment::ACQUIRE: c.swpa(r.vals[0], r.vals[1], m); break;
+		case Experiment::RELEASE: c.swpl(r.vals[0], r.vals[1], m); break;
+		case Experiment::ACQ_REL: c.swpal(r.vals[0], r.vals[1], m); break;
+		default: c.swp(r.vals[0], r.vals[1], m); break;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+// move position to the next link
+static void emit_chase(Compiler &c, Experiment &exp, const Gp &position) {
+	// the acquire loads only take a base
+	// register, next is at offset zero
+	switch (exp.mem_operation) {
+	case Experiment::LOAD_ACQUIRE:
+		c.ldar(position, ptr(position));
+		break;
+	case Experiment::LOAD_ACQUIRE_PC:
+		c.ldapr(position, ptr(position));
+		break;
+	default:
+		c.ldr(position, ptr(position, offsetof(Chain, next)));
+		break;
+	}
+}
+
+// access the link at position
+static void emit_operation(Compiler &c, Experiment &exp, const Gp &position, Registers &r) {
+	int64 lines = exp.lines_per_op();
+
+	switch (exp.mem_operation) {
+	case Experiment::LOAD:
+		c.ldr(r.vals[0], ptr(position, offsetof(Chain, data)));
+		break;
+	case Experiment::STORE:
+		c.str(r.vals[0], ptr(position, offsetof(Chain, data)));
+		break;
+	case Experiment::LOAD_ALL:
+		for (int64 j = 0; j < lines; j++)
+			c.ldr(r.vals[j], ptr(position, j*exp.bytes_per_line + offsetof(Chain, data)));
+		break;
+	case Experiment::STORE_ALL:
+		for (int64 j = 0; j < lines; j++)
+			c.str(r.vals[j], ptr(position, j*exp.bytes_per_line + offsetof(Chain, data)));
+		break;
+	case Experiment::LOAD_LINE:
+		for (int64 j = 0; j < lines; j++)
+			for (int64 k = 0; k < exp.bytes_per_line; k += VEC_BYTES)
+				c.ldr(r.vecs[(j*exp.bytes_per_line + k) / VEC_BYTES % VEC_LOADS],
+						ptr(position, j*exp.bytes_per_line + k));
+		break;
+	case Experiment::STORE_LINE:
+		for (int64 j = 0; j < lines; j++) {
+			for (int64 k = 0; k < exp.bytes_per_line; k += VEC_BYTES) {
+				int64 offset = j*exp.bytes_per_line + k;
+				if (offset < exp.pointer_size) {
+					// write the link back as it is
+					c.ldr(r.copy, ptr(position, offset));
+					c.str(r.copy, ptr(position, offset));
+				} else {
+					c.str(r.vecs[0], ptr(position, offset));
+				}
+			}
+		}
+		break;
+	case Experiment::STORE_NT:
+		c.stnp(r.vals[0], r.vals[0], ptr(position, offsetof(Chain, data)));
+		break;
+	case Experiment::STORE_LINE_NT:
+		for (int64 j = 0; j < lines; j++) {
+			for (int64 k = 0; k < exp.bytes_per_line; k += 2*VEC_BYTES) {
+				int64 offset = j*exp.bytes_per_line + k;
+				if (offset < exp.pointer_size) {
+					// write the link back as it is
+					c.ldp(r.copy, r.pair, ptr(position, offset));
+					c.stnp(r.copy, r.pair, ptr(position, offset));
+				} else {
+					c.stnp(r.vecs[0], r.vecs[1], pair_ptr(c, position, offset, r));
+				}
+			}
+		}
+		break;
+	case Experiment::ZERO_LINE:
+		// the zeroed line holds the link itself, so
+		// save its header and write it back after
+		c.ldr(r.next, ptr(position, offsetof(Chain, next)));
+		if (exp.prefetch_hint != Experiment::NONE)
+			c.ldr(r.ahead, ptr(position, offsetof(Lookahead, ahead)));
+		for (int64 offset = 0; offset < lines * exp.bytes_per_line; offset += r.zva_bytes) {
+			if (offset == 0) {
+				c.dc(imm(Predicate::DC::kZVA), position);
+			} else {
+				c.mov(r.addr, offset);
+				c.add(r.addr, r.addr, position);
+				c.dc(imm(Predicate::DC::kZVA), r.addr);
+			}
+		}
+		c.str(r.next, ptr(position, offsetof(Chain, next)));
+		if (exp.prefetch_hint != Experiment::NONE)
+			c.str(r.ahead, ptr(position, offsetof(Lookahead, ahead)));
+		break;
+	case Experiment::FLUSH:
+		// flush every line of the operation, and the
+		// next line too when the link runs into it
+		c.ldr(r.vals[0], ptr(position, offsetof(Chain, data)));
+		c.dc(imm(Predicate::DC::kCIVAC), position);
+		for (int64 j = 1; j < lines + exp.link_crosses_line(); j++) {
+			c.mov(r.addr, j*exp.bytes_per_line);
+			c.add(r.addr, r.addr, position);
+			c.dc(imm(Predicate::DC::kCIVAC), r.addr);
+		}
+		break;
+	case Experiment::STORE_RELEASE:
+		// STLR only takes a base register
+		c.add(r.addr, position, offsetof(Chain, data));
+		c.stlr(r.vals[0], ptr(r.addr));
+		break;
+	case Experiment::FENCE:
+		c.dmb(imm(Predicate::DB::kISH));
+		break;
+	case Experiment::FENCE_LOAD:
+		c.dmb(imm(Predicate::DB::kISHLD));
+		break;
+	case Experiment::ATOMIC_ADD:
+	case Experiment::CAS:
+	case Experiment::SWAP:
+		// LSE atomics only take a base register
+		c.add(r.addr, position, offsetof(Chain, data));
+		emit_atomic(c, exp, r);
+		break;
+	default:
+		break;
+	}
+}
+
+// execute the work of one iteration; the chains never
+// depend on the links, so they overlap with the misses
+static void emit_work(Compiler &c, Experiment &exp, Registers &r) {
+	for (int64 i = 0; i < exp.loop_length; i++) {
+		switch (exp.work) {
+		case Experiment::DEPENDENT:
+			c.add(r.work[0], r.work[0], 1);
+			break;
+		case Experiment::INDEPENDENT:
+			c.add(r.work[i % WORK_CHAINS], r.work[i % WORK_CHAINS], 1);
+			break;
+		case Experiment::FMA:
+			c.fmadd(r.acc.d(), r.acc.d(), r.mul.d(), r.mul.d());
+			break;
+		default:
+			c.nop();
+			break;
+		}
+	}
+}
+
+benchmark chase_pointers_a64(JitRuntime &rt, Experiment &exp) {
+	if (exp.mem_operation == Experiment::LOAD_LINE
+			|| exp.mem_operation == Experiment::STORE_LINE) {
+		if (exp.bytes_per_line % VEC_BYTES != 0) {
+			printf("Error making jit function (line size is not a multiple of %lld).\n", VEC_BYTES);
+			return 0;
+		}
+	}
+	if (exp.mem_operation == Experiment::STORE_LINE_NT) {
+		if (exp.bytes_per_line % (2*VEC_BYTES) != 0) {
+			printf("Error making jit function (line size is not a multiple of %lld).\n", 2*VEC_BYTES);
+			return 0;
+		}
+	}
+
+	// DC ZVA zeroes whole blocks, which must not
+	// spill over into the neighbouring lines
+	int64 zva_bytes = zva_block_size();
+	if (exp.mem_operation == Experiment::ZERO_LINE) {
+		if (zva_bytes == 0 || exp.bytes_per_line % zva_bytes != 0) {
+			printf("Error making jit function (DC ZVA unavailable or larger than a line).\n");
+			return 0;
+		}
+	}
+
+	// Create Compiler.
+	CodeHolder code;                  // Holds code and relocation information.
+  	code.init(rt.environment());      // Initialize code to match the JIT environment. 
+
+	Compiler c(&code);	// Create and attach Compiler to code.
+
+  	// Tell compiler the function prototype we want. It allocates variables representing
+	// function arguments that can be accessed through Compiler or Function instance.
+	FuncNode* funcNode = c.addFunc(FuncSignatureT<void, Chain**, int64_t>());
+
+	// Try to generate function without prolog/epilog code:
+	// c.getFunction()->setHint(asmjit::FUNCTION_HINT_NAKED, true);
+
+	// Create labels.
+	Label L_Loop = c.newLabel();
+	Label L_End = c.newLabel();
+
+	// Function arguments.
+	Gp chain=c.newUIntPtr();
+	funcNode->setArg(0,chain);
+
+
+	// Number of passes through the unrolled loop
+	Gp count = c.newInt64();
+	funcNode->setArg(1,count);
+	c.cbz(count, L_End);
+
+	// Current position
+	std::vector<Gp> positions(exp.chains_per_thread);
+	for (int i = 0; i < exp.chains_per_thread; i++) {
+		positions[i] = c.newUIntPtr();
+		c.ldr(positions[i], ptr(chain,i*sizeof(Chain *)));
+	}
+
+	Registers r;
+	int64 val_num = exp.mem_operation==Experiment::STORE_ALL||exp.mem_operation==Experiment::LOAD_ALL?exp.lines_per_op():1;
+	// atomics add or swap in 1 (vals[0]), and
+	// compare with and swap in 0 (vals[1], vals[2])
+	if (exp.is_atomic())
+		val_num = 3;
+	r.vals.resize(val_num);
+	for (int64 i = 0; i < val_num; i++) {
+		r.vals[i] = c.newUInt64();
+		c.mov(r.vals[i], exp.is_atomic() ? (i == 0) : 100 * i);
+	}
+	if (exp.mem_operation == Experiment::LOAD_LINE
+			|| exp.mem_operation == Experiment::STORE_LINE
+			|| exp.mem_operation == Experiment::STORE_LINE_NT) {
+		r.vecs.resize(VEC_LOADS);
+		for (int i = 0; i < VEC_LOADS; i++) {
+			r.vecs[i] = c.newVecQ();
+			c.movi(r.vecs[i].b16(), imm(i));
+		}
+		r.copy = c.newVecQ();
+		r.pair = c.newVecQ();
+	}
+	r.next = c.newUIntPtr();
+	r.ahead = c.newUIntPtr();
+	r.addr = c.newUIntPtr();
+	r.zva_bytes = zva_bytes;
+	if (exp.work == Experiment::DEPENDENT || exp.work == Experiment::INDEPENDENT) {
+		r.work.resize(WORK_CHAINS);
+		for (int i = 0; i < WORK_CHAINS; i++) {
+			r.work[i] = c.newUInt64();
+			c.mov(r.work[i], 0);
+		}
+	}
+	if (exp.work == Experiment::FMA) {
+		// zeros never overflow or go denormal
+		r.acc = c.newVecD();
+		r.mul = c.newVecD();
+		c.movi(r.acc.b16(), imm(0));
+		c.movi(r.mul.b16(), imm(0));
+	}
+
+	// Prefetch target
+	Gp lookahead = c.newUIntPtr();
+	uint32_t prefetch_op = PLDL1KEEP;
+	switch (exp.prefetch_hint) {
+	case Experiment::T1:
+		prefetch_op = PLDL2KEEP;
+		break;
+	case Experiment::T2:
+		prefetch_op = PLDL3KEEP;
+		break;
+	case Experiment::NTA:
+		prefetch_op = PLDL1STRM;
+		break;
+	default:
+		break;
+	}
+
+	// Loop.
+	c.bind(L_Loop);
+
+	// Process all links, unroll times per test
+	for (int u = 0; u < exp.unroll; u++) {
+		for (int i = 0; i < exp.chains_per_thread; i++) {
+			// Chase pointer
+			emit_chase(c, exp, positions[i]);
+			if (exp.mem_operation == Experiment::MIX) {
+				// the unroll is a multiple of the period
+				if (exp.mix_loads(u))
+					c.ldr(r.vals[0], ptr(positions[i], offsetof(Chain, data)));
+				else
+					c.str(r.vals[0], ptr(positions[i], offsetof(Chain, data)));
+			} else {
+				emit_operation(c, exp, positions[i], r);
+			}
+
+			// Prefetch ahead
+			if (exp.prefetch_hint != Experiment::NONE) {
+				c.ldr(lookahead, ptr(positions[i], offsetof(Lookahead, ahead)));
+				c.prfm(imm(prefetch_op), ptr(lookahead));
+			}
+		}
+
+		// Wait
+		emit_work(c, exp, r);
+	}
+
+	// Test if end reached
+	c.subs(count, count, 1);
+	c.b(CondCode::kNE,L_Loop);
+	c.bind(L_End);
+
+
+	// Finish.
+	c.endFunc();
+	c.finalize();
+
+	// Add the generated code to the runtime.
+  	benchmark fn;
+  	Error err = rt.add(&fn, &code);
+	// Handle a possible error returned by AsmJit.
+	if (err) {
+		printf("Error making jit function (%u).\n", err);
+		return 0;
+	}
+
+	return fn;
+}
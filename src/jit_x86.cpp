@@ -0,0 +1,374 @@
+/*******************************************************************************
+ * Copyright (c) 2006 International Business Machines Corporation.             *
+ * All rights reserved. This program and the accompanying materials            *
+ * are made available under the terms of the Common Public License v1.0        *
+ * which accompanies this distribution, and is available at                    *
+ * http://www.opensource.org/licenses/cpl1.0.php                               *
+ *                                                                             *
+ * Contributors:                                                               *
+ *    Douglas M. Pase - initial API and implementation                         *
+ *    Tim Besard - prefetching, JIT compilation                                *
+ *******************************************************************************/
+
+//
+// Configuration
+//
+
+// Implementation header
+#include "jit.h"
+
+// System includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <vector>
+
+// Local includes
+#include <asmjit/x86.h>
+
+
+//
+// Implementation
+//
+
+using namespace asmjit;
+using namespace asmjit::x86;
+
+// vector registers loads rotate through
+static const int VEC_LOADS = 4;
+// interleaved chains of independent work
+static const int WORK_CHAINS = 4;
+
+// registers shared by the operations on all links
+struct Registers {
+	std::vector<Gp> vals;	// scalar values loaded or stored
+	std::vector<Vec> vecs;	// vector values loaded or stored
+	Vec copy;				// vector holding a chunk of the link itself
+	int64 vec_bytes;		// bytes moved by a single vector access
+	bool clflushopt;		// flush with CLFLUSHOPT rather than CLFLUSH
+	std::vector<Gp> work;	// integer work accumulators
+	Vec acc, mul;			// floating point work accumulator and factor
+};
+
+// move a vector between a register and memory, using
+// the widest instruction the vector size allows
+static void emit_vector_load(Compiler &c, const Vec &v, const Mem &m, int64 vec_bytes) {
+	if (vec_bytes == 64)
+		c.vmovdqu64(v, m);
+	else if (vec_bytes == 32)
+		c.vmovdqu(v, m);
+	else
+		c.movdqu(v, m);
+}
+
+static void emit_vector_store(Compiler &c, const Mem &m, const Vec &v, int64 vec_bytes) {
+	if (vec_bytes == 64)
+		c.vmovdqu64(m, v);
+	else if (vec_bytes == 32)
+		c.vmovdqu(m, v);
+	else
+		c.movdqu(m, v);
+}
+
+// non-temporal stores need the address aligned
+// to the vector size, which links in an aligned
+// chain are as long as the line size allows it
+static void emit_vector_store_nt(Compiler &c, const Mem &m, const Vec &v, int64 vec_bytes) {
+	if (vec_bytes == 16)
+		c.movntdq(m, v);
+	else
+		c.vmovntdq(m, v);
+}
+
+// access the link at position
+static void emit_operation(Compiler &c, Experiment &exp, const Gp &position, Registers &r) {
+	int64 lines = exp.lines_per_op();
+
+	switch (exp.mem_operation) {
+	case Experiment::LOAD:
+		c.mov(r.vals[0], ptr(position, offsetof(Chain, data)));
+		break;
+	case Experiment::STORE:
+		c.mov(ptr(position, offsetof(Chain, data)), r.vals[0]);
+		break;
+	case Experiment::LOAD_ALL:
+		for (int64 j = 0; j < lines; j++)
+			c.mov(r.vals[j], ptr(position, j*exp.bytes_per_line + offsetof(Chain, data)));
+		break;
+	case Experiment::STORE_ALL:
+		for (int64 j = 0; j < lines; j++)
+			c.mov(ptr(position, j*exp.bytes_per_line + offsetof(Chain, data)), r.vals[j]);
+		break;
+	case Experiment::LOAD_LINE:
+		for (int64 j = 0; j < lines; j++)
+			for (int64 k = 0; k < exp.bytes_per_line; k += r.vec_bytes)
+				emit_vector_load(c, r.vecs[(j*exp.bytes_per_line + k) / r.vec_bytes % VEC_LOADS],
+						ptr(position, j*exp.bytes_per_line + k), r.vec_bytes);
+		break;
+	case Experiment::STORE_LINE:
+		for (int64 j = 0; j < lines; j++) {
+			for (int64 k = 0; k < exp.bytes_per_line; k += r.vec_bytes) {
+				int64 offset = j*exp.bytes_per_line + k;
+				if (offset < exp.pointer_size) {
+					// write the link back as it is
+					emit_vector_load(c, r.copy, ptr(position, offset), r.vec_bytes);
+					emit_vector_store(c, ptr(position, offset), r.copy, r.vec_bytes);
+				} else {
+					emit_vector_store(c, ptr(position, offset), r.vecs[0], r.vec_bytes);
+				}
+			}
+		}
+		break;
+	case Experiment::STORE_NT:
+		c.movnti(ptr(position, offsetof(Chain, data)), r.vals[0]);
+		break;
+	case Experiment::STORE_LINE_NT:
+		for (int64 j = 0; j < lines; j++) {
+			for (int64 k = 0; k < exp.bytes_per_line; k += r.vec_bytes) {
+				int64 offset = j*exp.bytes_per_line + k;
+				if (offset < exp.pointer_size) {
+					// write the link back as it is
+					emit_vector_load(c, r.copy, ptr(position, offset), r.vec_bytes);
+					emit_vector_store_nt(c, ptr(position, offset), r.copy, r.vec_bytes);
+				} else {
+					emit_vector_store_nt(c, ptr(position, offset), r.vecs[0], r.vec_bytes);
+				}
+			}
+		}
+		break;
+	case Experiment::FLUSH:
+		// flush every line of the operation, and the
+		// next line too when the link runs into it
+		c.mov(r.vals[0], ptr(position, offsetof(Chain, data)));
+		for (int64 j = 0; j < lines + exp.link_crosses_line(); j++) {
+			if (r.clflushopt)
+				c.clflushopt(ptr(position, j*exp.bytes_per_line));
+			else
+				c.clflush(ptr(position, j*exp.bytes_per_line));
+		}
+		break;
+	// every locked instruction is a full barrier
+	// on x86, so the memory order makes no difference
+	case Experiment::ATOMIC_ADD:
+		c.lock().add(qword_ptr(position, offsetof(Chain, data)), 1);
+		break;
+	case Experiment::CAS:
+		// data is zero, so comparing with zero always
+		// succeeds and the old value stays zero
+		c.lock().cmpxchg(qword_ptr(position, offsetof(Chain, data)), r.vals[2], r.vals[1]);
+		break;
+	case Experiment::SWAP:
+		c.xchg(qword_ptr(position, offsetof(Chain, data)), r.vals[0]);
+		break;
+	case Experiment::STORE_RELEASE:
+		// every x86 store has release semantics
+		c.mov(ptr(position, offsetof(Chain, data)), r.vals[0]);
+		break;
+	case Experiment::FENCE:
+		c.mfence();
+		break;
+	case Experiment::FENCE_LOAD:
+		c.lfence();
+		break;
+	default:
+		break;
+	}
+}
+
+// execute the work of one iteration; the chains never
+// depend on the links, so they overlap with the misses
+static void emit_work(Compiler &c, Experiment &exp, Registers &r) {
+	for (int64 i = 0; i < exp.loop_length; i++) {
+		switch (exp.work) {
+		case Experiment::DEPENDENT:
+			c.add(r.work[0], 1);
+			break;
+		case Experiment::INDEPENDENT:
+			c.add(r.work[i % WORK_CHAINS], 1);
+			break;
+		case Experiment::FMA:
+			c.vfmadd231sd(r.acc, r.mul, r.mul);
+			break;
+		default:
+			c.nop();
+			break;
+		}
+	}
+}
+
+benchmark chase_pointers_x86(JitRuntime &rt, Experiment &exp) {
+	// Use the widest vectors the host supports that fit in a line.
+	const CpuFeatures::X86 &features = rt.cpuFeatures().x86();
+	int64 vec_bytes = 16;
+	if (features.hasAVX512_F() && exp.bytes_per_line % 64 == 0)
+		vec_bytes = 64;
+	else if (features.hasAVX() && exp.bytes_per_line % 32 == 0)
+		vec_bytes = 32;
+	if (exp.mem_operation == Experiment::LOAD_LINE
+			|| exp.mem_operation == Experiment::STORE_LINE
+			|| exp.mem_operation == Experiment::STORE_LINE_NT) {
+		if (exp.bytes_per_line % vec_bytes != 0) {
+			printf("Error making jit function (line size is not a multiple of %lld).\n", vec_bytes);
+			return 0;
+		}
+	}
+	if (exp.mem_operation == Experiment::ZERO_LINE) {
+		printf("Error making jit function (zero_line is not available on x86).\n");
+		return 0;
+	}
+	if (exp.work == Experiment::FMA && !features.hasFMA()) {
+		printf("Error making jit function (fma is not available on this host).\n");
+		return 0;
+	}
+
+	// Create Compiler.
+	CodeHolder code;                  // Holds code and relocation information.
+	code.init(rt.environment());      // Initialize code to match the JIT environment.
+
+	Compiler c(&code);	// Create and attach Compiler to code.
+
+	// Tell compiler the function prototype we want. It allocates variables representing
+	// function arguments that can be accessed through Compiler or Function instance.
+	FuncNode* funcNode = c.addFunc(FuncSignatureT<void, Chain**, int64_t>());
+
+	// Create labels.
+	Label L_Loop = c.newLabel();
+	Label L_End = c.newLabel();
+
+	// Function arguments.
+	Gp chain = c.newUIntPtr();
+	funcNode->setArg(0, chain);
+
+
+	// Number of passes through the unrolled loop
+	Gp count = c.newInt64();
+	funcNode->setArg(1, count);
+	c.test(count, count);
+	c.jz(L_End);
+
+	// Current position
+	std::vector<Gp> positions(exp.chains_per_thread);
+	for (int i = 0; i < exp.chains_per_thread; i++) {
+		positions[i] = c.newUIntPtr();
+		c.mov(positions[i], ptr(chain, i*sizeof(Chain *)));
+	}
+
+	Registers r;
+	r.vec_bytes = vec_bytes;
+	r.clflushopt = features.hasCLFLUSHOPT();
+	int64 val_num = exp.mem_operation==Experiment::STORE_ALL||exp.mem_operation==Experiment::LOAD_ALL?exp.lines_per_op():1;
+	// atomics add or swap in 1 (vals[0]), and
+	// compare with and swap in 0 (vals[1], vals[2])
+	if (exp.is_atomic())
+		val_num = 3;
+	r.vals.resize(val_num);
+	for (int64 i = 0; i < val_num; i++) {
+		r.vals[i] = c.newUInt64();
+		c.mov(r.vals[i], exp.is_atomic() ? (i == 0) : 100 * i);
+	}
+	if (exp.mem_operation == Experiment::LOAD_LINE
+			|| exp.mem_operation == Experiment::STORE_LINE
+			|| exp.mem_operation == Experiment::STORE_LINE_NT) {
+		r.vecs.resize(VEC_LOADS);
+		for (int i = 0; i < VEC_LOADS + 1; i++) {
+			Vec v;
+			if (vec_bytes == 64) {
+				v = c.newZmm();
+				c.vpxord(v, v, v);
+			} else if (vec_bytes == 32) {
+				v = c.newYmm();
+				c.vxorps(v, v, v);
+			} else {
+				v = c.newXmm();
+				c.pxor(v, v);
+			}
+			if (i < VEC_LOADS)
+				r.vecs[i] = v;
+			else
+				r.copy = v;
+		}
+	}
+	if (exp.work == Experiment::DEPENDENT || exp.work == Experiment::INDEPENDENT) {
+		r.work.resize(WORK_CHAINS);
+		for (int i = 0; i < WORK_CHAINS; i++) {
+			r.work[i] = c.newUInt64();
+			c.xor_(r.work[i], r.work[i]);
+		}
+	}
+	if (exp.work == Experiment::FMA) {
+		// zeros never overflow or go denormal
+		r.acc = c.newXmmSd();
+		r.mul = c.newXmmSd();
+		c.xorpd(r.acc, r.acc);
+		c.xorpd(r.mul, r.mul);
+	}
+
+	// Prefetch target
+	Gp lookahead = c.newUIntPtr();
+
+	// Loop.
+	c.bind(L_Loop);
+
+	// Process all links, unroll times per test
+	for (int u = 0; u < exp.unroll; u++) {
+		for (int i = 0; i < exp.chains_per_thread; i++) {
+			// Chase pointer, every x86
+			// load has acquire semantics
+			c.mov(positions[i], ptr(positions[i], offsetof(Chain, next)));
+			if (exp.mem_operation == Experiment::MIX) {
+				// the unroll is a multiple of the period
+				if (exp.mix_loads(u))
+					c.mov(r.vals[0], ptr(positions[i], offsetof(Chain, data)));
+				else
+					c.mov(ptr(positions[i], offsetof(Chain, data)), r.vals[0]);
+			} else {
+				emit_operation(c, exp, positions[i], r);
+			}
+
+			// Prefetch ahead
+			if (exp.prefetch_hint != Experiment::NONE) {
+				c.mov(lookahead, ptr(positions[i], offsetof(Lookahead, ahead)));
+				switch (exp.prefetch_hint) {
+				case Experiment::T0:
+					c.prefetcht0(ptr(lookahead));
+					break;
+				case Experiment::T1:
+					c.prefetcht1(ptr(lookahead));
+					break;
+				case Experiment::T2:
+					c.prefetcht2(ptr(lookahead));
+					break;
+				case Experiment::NTA:
+					c.prefetchnta(ptr(lookahead));
+					break;
+				default:
+					break;
+				}
+			}
+		}
+
+		// Wait
+		emit_work(c, exp, r);
+	}
+
+	// Test if end reached
+	c.sub(count, 1);
+	c.jnz(L_Loop);
+	c.bind(L_End);
+
+
+	// Finish.
+	c.endFunc();
+	c.finalize();
+
+	// Add the generated code to the runtime.
+	benchmark fn;
+	Error err = rt.add(&fn, &code);
+	// Handle a possible error returned by AsmJit.
+	if (err) {
+		printf("Error making jit function (%u).\n", err);
+		return 0;
+	}
+
+	return fn;
+}
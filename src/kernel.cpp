@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * Copyright (c) 2006 International Business Machines Corporation.             *
+ * All rights reserved. This program and the accompanying materials            *
+ * are made available under the terms of the Common Public License v1.0        *
+ * which accompanies this distribution, and is available at                    *
+ * http://www.opensource.org/licenses/cpl1.0.php                               *
+ *                                                                             *
+ * Contributors:                                                               *
+ *    Douglas M. Pase - initial API and implementation                         *
+ *    Tim Besard - prefetching, JIT compilation                                *
+ *******************************************************************************/
+
+//
+// Configuration
+//
+
+// Implementation header
+#include "kernel.h"
+
+// System includes
+#include <tuple>
+
+// Local includes
+#include "native.h"
+#include "stream.h"
+#if defined(HAVE_JIT)
+#include "jit.h"
+#endif
+
+
+//
+// Implementation
+//
+
+Lock Kernel::cache_mutex;
+std::map<Kernel::Key, benchmark> Kernel::cache;
+
+#if defined(HAVE_JIT)
+// one JIT runtime (and so one copy of the code)
+// per numa domain. the code is written by the
+// first thread of the domain to ask for it, so
+// first touch places it in that domain.
+static std::map<int32, asmjit::JitRuntime*> runtimes;
+#endif
+
+Kernel::Key::Key(Experiment &e, int32 domain) :
+		kernel(e.kernel),
+		mem_operation(e.mem_operation),
+		read_percent(e.read_percent),
+		memory_order(e.memory_order),
+		chains_per_thread(e.chains_per_thread),
+		loop_length(e.loop_length),
+		work(e.work),
+		unroll(e.unroll),
+		stride(e.stride),
+		bytes_per_line(e.bytes_per_line),
+		prefetch_hint(e.prefetch_hint),
+		domain(domain) {
+}
+
+bool Kernel::Key::operator<(const Key &k) const {
+	return std::tie(kernel, mem_operation, read_percent, memory_order,
+			chains_per_thread, loop_length, work, unroll, stride,
+			bytes_per_line, prefetch_hint, domain)
+		< std::tie(k.kernel, k.mem_operation, k.read_percent, k.memory_order,
+			k.chains_per_thread, k.loop_length, k.work, k.unroll, k.stride,
+			k.bytes_per_line, k.prefetch_hint, k.domain);
+}
+
+benchmark Kernel::get(Experiment &e, int32 domain) {
+	Key key(e, domain);
+
+	Kernel::cache_mutex.lock();
+	std::map<Key, benchmark>::iterator it = Kernel::cache.find(key);
+	if (it != Kernel::cache.end()) {
+		benchmark bench = it->second;
+		Kernel::cache_mutex.unlock();
+		return bench;
+	}
+
+	benchmark bench = 0;
+#if defined(HAVE_JIT)
+	if (e.kernel == Experiment::JIT) {
+		if (runtimes.find(domain) == runtimes.end()) {
+			runtimes[domain] = new asmjit::JitRuntime();
+		}
+		bench = chase_pointers(*runtimes[domain], e);
+	}
+#endif
+	if (e.kernel == Experiment::NATIVE) {
+		bench = native_chase_pointers(e);
+	}
+	if (e.is_stream()) {
+		bench = stream_kernel(e);
+	}
+	if (bench != 0) {
+		Kernel::cache[key] = bench;
+	}
+	Kernel::cache_mutex.unlock();
+
+	return bench;
+}
@@ -0,0 +1,74 @@
+/*******************************************************************************
+ * Copyright (c) 2006 International Business Machines Corporation.             *
+ * All rights reserved. This program and the accompanying materials            *
+ * are made available under the terms of the Common Public License v1.0        *
+ * which accompanies this distribution, and is available at                    *
+ * http://www.opensource.org/licenses/cpl1.0.php                               *
+ *                                                                             *
+ * Contributors:                                                               *
+ *    Douglas M. Pase - initial API and implementation                         *
+ *    Tim Besard - prefetching, JIT compilation                                *
+ *******************************************************************************/
+
+//
+// Configuration
+//
+
+// Include guard
+#if !defined(KERNEL_H)
+#define KERNEL_H
+
+// System includes
+#include <map>
+
+// Local includes
+#include "lock.h"
+#include "chain.h"
+#include "types.h"
+#include "experiment.h"
+
+
+//
+// Class definition
+//
+
+// chases each chain from its root for count
+// passes of the unrolled loop, i.e. for
+// count * unroll links per chain
+typedef void (*benchmark)(Chain** root, int64 count);
+
+/*
+ * Benchmark kernels only depend on the few fields of the Experiment that
+ * change the generated code, so they are compiled once for each distinct
+ * set of those fields and for each NUMA domain, and then shared by all the
+ * threads running in that domain.
+ */
+
+class Kernel {
+public:
+	static benchmark get(Experiment &e, int32 domain);
+
+private:
+	struct Key {
+		int32 kernel;
+		int32 mem_operation;
+		int64 read_percent;
+		int32 memory_order;
+		int64 chains_per_thread;
+		int64 loop_length;
+		int32 work;
+		int64 unroll;
+		int64 stride;
+		int64 bytes_per_line;
+		int32 prefetch_hint;
+		int32 domain;
+
+		Key(Experiment &e, int32 domain);
+		bool operator<(const Key &k) const;
+	};
+
+	static Lock cache_mutex; // protects the cache
+	static std::map<Key, benchmark> cache; // compiled kernels
+};
+
+#endif
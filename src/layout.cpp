@@ -0,0 +1,212 @@
+/*******************************************************************************
+ * Copyright (c) 2006 International Business Machines Corporation.             *
+ * All rights reserved. This program and the accompanying materials            *
+ * are made available under the terms of the Common Public License v1.0        *
+ * which accompanies this distribution, and is available at                    *
+ * http://www.opensource.org/licenses/cpl1.0.php                               *
+ *                                                                             *
+ * Contributors:                                                               *
+ *    Douglas M. Pase - initial API and implementation                         *
+ *    Tim Besard - prefetching, JIT compilation                                *
+ *******************************************************************************/
+
+//
+// Configuration
+//
+
+// Implementation header
+#include "layout.h"
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Local includes
+#include "chain.h"
+
+
+//
+// Implementation
+//
+
+const char Layout::MAGIC[8] = { 'p', 'c', 'c', 'h', 'a', 'i', 'n', '2' };
+
+Layout::Layout() :
+		head(NULL), counts(NULL), first(NULL), size(0) {
+}
+
+Layout::~Layout() {
+	if (this->head != NULL) {
+		munmap((void*) this->head, this->size);
+	}
+}
+
+// map the file for relocation into the chains,
+// printing the reason when it cannot be used
+int Layout::load(const char* path) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		printf("chase: cannot open chain file '%s'\n", path);
+		return 1;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(Header)) {
+		printf("chase: chain file '%s' is too short\n", path);
+		close(fd);
+		return 1;
+	}
+
+	void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		printf("chase: cannot map chain file '%s'\n", path);
+		return 1;
+	}
+	this->head = (const Header*) map;
+	this->counts = (const uint64*) (this->head + 1);
+	this->size = st.st_size;
+
+	const Header* h = this->head;
+	if (memcmp(h->magic, MAGIC, sizeof(MAGIC)) != 0) {
+		printf("chase: '%s' is not a chain file\n", path);
+		return 1;
+	}
+	if (h->num_threads <= 0 || h->chains_per_thread <= 0
+			|| (uint64) this->size < sizeof(Header)
+					+ h->num_threads * h->chains_per_thread * sizeof(uint64)) {
+		printf("chase: chain file '%s' does not match its header\n", path);
+		return 1;
+	}
+
+	// every chain has links, and together
+	// they fill the rest of the file
+	int64 n = h->num_threads * h->chains_per_thread;
+	this->first = this->counts + n;
+	uint64 total = 0;
+	for (int64 i = 0; i < n; i++) {
+		if (this->counts[i] == 0 || (uint64) this->size < this->counts[i] * sizeof(uint64)) {
+			printf("chase: chain file '%s' does not match its header\n", path);
+			return 1;
+		}
+		this->starts.push_back(total);
+		total += this->counts[i];
+	}
+	if ((uint64) this->size != sizeof(Header) + (n + total) * sizeof(uint64)) {
+		printf("chase: chain file '%s' does not match its header\n", path);
+		return 1;
+	}
+
+	return 0;
+}
+
+// the geometry and layout options of the file
+// replace those of the command line
+void Layout::apply(Experiment &e) {
+	const Header* h = this->head;
+	e.bytes_per_line = h->bytes_per_line;
+	e.bytes_per_page = h->bytes_per_page;
+	e.bytes_per_chain = h->bytes_per_chain;
+	e.num_threads = h->num_threads;
+	e.chains_per_thread = h->chains_per_thread;
+	e.access_pattern = (decltype(e.access_pattern)) h->access_pattern;
+	e.stride = h->stride;
+	e.window = h->window;
+	e.zipf_theta = h->zipf_theta;
+	e.random_offset = h->link_offset < 0;
+	e.link_offset = h->link_offset < 0 ? 0 : h->link_offset;
+	e.split = (decltype(e.split)) h->split;
+	e.seed = h->seed;
+}
+
+// the file holds the given chains, and all
+// links lie within chains of the given size
+bool Layout::fits(int64 threads, int64 chains, int64 bytes) {
+	if (threads != this->head->num_threads || chains != this->head->chains_per_thread) {
+		return false;
+	}
+
+	int64 n = (this->size - sizeof(Header)) / sizeof(uint64)
+			- this->head->num_threads * this->head->chains_per_thread;
+	for (int64 i = 0; i < n; i++) {
+		if ((uint64) bytes - this->head->link_size < this->first[i]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// create the file with the header and the links
+// of every chain, sized for all their offsets
+void Layout::create(const char* path, Experiment &e, const std::vector<uint64> &links) {
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		fprintf(stderr, "Failed to open chain file '%s'.\n", path);
+		exit(1);
+	}
+
+	uint64 total = 0;
+	for (size_t i = 0; i < links.size(); i++) {
+		total += links[i];
+	}
+	off_t size = sizeof(Header) + (links.size() + total) * sizeof(uint64);
+	bool failed = ftruncate(fd, size) != 0;
+
+	Header h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, MAGIC, sizeof(MAGIC));
+	h.link_size = e.pointer_size;
+	h.bytes_per_line = e.bytes_per_line;
+	h.bytes_per_page = e.bytes_per_page;
+	h.bytes_per_chain = e.bytes_per_chain;
+	h.num_threads = e.num_threads;
+	h.chains_per_thread = e.chains_per_thread;
+	h.access_pattern = e.access_pattern;
+	h.stride = e.stride;
+	h.window = e.window;
+	h.zipf_theta = e.zipf_theta;
+	h.link_offset = e.random_offset ? -1 : e.link_offset;
+	h.split = e.split;
+	h.seed = e.seed;
+	failed |= pwrite(fd, &h, sizeof(h), 0) != sizeof(h);
+
+	ssize_t bytes = links.size() * sizeof(uint64);
+	failed |= pwrite(fd, &links[0], bytes, sizeof(h)) != bytes;
+	failed |= close(fd) != 0;
+	if (failed) {
+		fprintf(stderr, "Failed to write chain file '%s'.\n", path);
+		exit(1);
+	}
+}
+
+// write the offsets of the chain at the given index
+// of all chains. every chain has its own place in the
+// created file, so the threads write without waiting
+// on each other.
+void Layout::save(const char* path, int64 index,
+		const std::vector<uint64> &links, const std::vector<uint64> &offsets) {
+	int fd = open(path, O_WRONLY);
+	if (fd < 0) {
+		fprintf(stderr, "Failed to open chain file '%s'.\n", path);
+		exit(1);
+	}
+
+	off_t place = sizeof(Header) + links.size() * sizeof(uint64);
+	for (int64 i = 0; i < index; i++) {
+		place += links[i] * sizeof(uint64);
+	}
+
+	ssize_t bytes = offsets.size() * sizeof(uint64);
+	bool failed = pwrite(fd, &offsets[0], bytes, place) != bytes;
+	failed |= close(fd) != 0;
+	if (failed) {
+		fprintf(stderr, "Failed to write chain file '%s'.\n", path);
+		exit(1);
+	}
+}
@@ -0,0 +1,87 @@
+/*******************************************************************************
+ * Copyright (c) 2006 International Business Machines Corporation.             *
+ * All rights reserved. This program and the accompanying materials            *
+ * are made available under the terms of the Common Public License v1.0        *
+ * which accompanies this distribution, and is available at                    *
+ * http://www.opensource.org/licenses/cpl1.0.php                               *
+ *                                                                             *
+ * Contributors:                                                               *
+ *    Douglas M. Pase - initial API and implementation                         *
+ *    Tim Besard - prefetching, JIT compilation                                *
+ *******************************************************************************/
+
+//
+// Configuration
+//
+
+// Include guard
+#if !defined(LAYOUT_H)
+#define LAYOUT_H
+
+// System includes
+#include <vector>
+
+// Local includes
+#include "types.h"
+#include "experiment.h"
+
+
+//
+// Class definition
+//
+
+// the links of all chains of a test, saved as byte
+// offsets from the start of their chain in chasing
+// order, after a header with the geometry of the
+// experiment and the number of links of every
+// chain. the file is in native byte order.
+class Layout {
+public:
+	struct Header {
+		char magic[8];
+		uint64 link_size;
+		int64 bytes_per_line;
+		int64 bytes_per_page;
+		int64 bytes_per_chain;
+		int64 num_threads;
+		int64 chains_per_thread;
+		int64 access_pattern;
+		int64 stride;
+		int64 window;
+		double zipf_theta;
+		int64 link_offset;		// -1 for random offsets
+		int64 split;
+		uint64 seed;
+	};
+
+	Layout();
+	~Layout();
+	int load(const char* path);
+	void apply(Experiment &e);
+	bool fits(int64 threads, int64 chains, int64 bytes);
+
+	int64 link_size() {
+		return this->head->link_size;
+	}
+	int64 links(int64 thread, int64 chain) {
+		return this->counts[thread * this->head->chains_per_thread + chain];
+	}
+	const uint64* offsets(int64 thread, int64 chain) {
+		return this->first + this->starts[thread * this->head->chains_per_thread + chain];
+	}
+
+	static void create(const char* path, Experiment &e, const std::vector<uint64> &links);
+	static void save(const char* path, int64 index,
+			const std::vector<uint64> &links, const std::vector<uint64> &offsets);
+
+	const static char MAGIC[8];
+
+private:
+	const Header* head;
+	const uint64* counts;	// links of every chain
+	const uint64* first;	// offsets of the first chain
+	std::vector<int64> starts;	// index of the first offset of every chain
+	int64 size;
+};
+
+#endif
@@ -72,8 +72,9 @@ int main(int argc, char* argv[]) {
 	double clk_res = Timer::resolution();
 
 	Experiment e;
-	if (e.parse_args(argc, argv)) {
-		return 0;
+	int status = e.parse_args(argc, argv);
+	if (status != 0) {
+		return status < 0 ? 0 : status;
 	}
 
 	SpinBarrier sb(e.num_threads);
@@ -87,7 +88,19 @@ int main(int argc, char* argv[]) {
 		r[i].wait();
 	}
 
+	if (0 < Run::skipped_hops()) {
+		fprintf(stderr, "chase: %lld visits skipped, their lines had no free link\n", Run::skipped_hops());
+	}
+
 	int64 ops = Run::ops_per_chain();
+	if (e.kernel == Experiment::FAULT) {
+		Output::fault(e, ops, Run::fault_seconds());
+		return 0;
+	}
+	if (e.mlp) {
+		Output::mlp(e, ops, Run::mlp_iterations(), Run::mlp_seconds());
+		return 0;
+	}
 	std::vector<double> seconds = Run::seconds();
 
 	Output::print(e, ops, seconds, clk_res);
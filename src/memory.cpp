@@ -0,0 +1,409 @@
+/*******************************************************************************
+ * Copyright (c) 2006 International Business Machines Corporation.             *
+ * All rights reserved. This program and the accompanying materials            *
+ * are made available under the terms of the Common Public License v1.0        *
+ * which accompanies this distribution, and is available at                    *
+ * http://www.opensource.org/licenses/cpl1.0.php                               *
+ *                                                                             *
+ * Contributors:                                                               *
+ *    Douglas M. Pase - initial API and implementation                         *
+ *    Tim Besard - prefetching, JIT compilation                                *
+ *******************************************************************************/
+
+//
+// Configuration
+//
+
+// Implementation header
+#include "memory.h"
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <vector>
+#if defined(NUMA)
+#include <numa.h>
+#include <numaif.h>
+#endif
+
+// Local includes
+#include "thread.h"
+
+#if !defined(MAP_HUGE_SHIFT)
+#define MAP_HUGE_SHIFT 26
+#endif
+
+
+//
+// Implementation
+//
+
+// read a single number from a file, as the
+// kernel exports its settings under /sys
+static int64 read_number(const char* path, int64 otherwise) {
+	FILE* f = fopen(path, "r");
+	if (f == NULL) {
+		return otherwise;
+	}
+	long long value = otherwise;
+	if (fscanf(f, "%lld", &value) != 1) {
+		value = otherwise;
+	}
+	fclose(f);
+
+	return value;
+}
+
+// helper touching a range of pages within
+// the domain the memory is bound to
+class Toucher: public Thread {
+public:
+	Toucher(char* begin, char* end, int32 domain) :
+			begin(begin), end(end), domain(domain) {
+	}
+	~Toucher() {
+	}
+
+	int run() {
+#if defined(NUMA)
+		numa_run_on_node(this->domain);
+#endif
+		touch(this->begin, this->end);
+		return 0;
+	}
+
+	// write a byte of every page, faulting it in
+	static void touch(char* begin, char* end) {
+		int64 step = sysconf(_SC_PAGESIZE);
+		for (volatile char* p = begin; p < end; p += step) {
+			*p = 0;
+		}
+	}
+
+private:
+	char* begin;
+	char* end;
+	int32 domain;
+};
+
+Memory::Memory() :
+		addr(NULL), bytes(0), domain(0), fd(-1), offset(0) {
+}
+
+Memory::~Memory() {
+	if (this->addr != NULL) {
+		munmap(this->addr, this->bytes);
+	}
+}
+
+int64 Memory::huge_page_size(int32 pages) {
+	switch (pages) {
+	case Experiment::HUGE_PAGES_2M:
+		return 2 << 20;
+	case Experiment::HUGE_PAGES_1G:
+		return 1 << 30;
+	case Experiment::TRANSPARENT_HUGE_PAGES:
+		return read_number("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", 2 << 20);
+	}
+	return sysconf(_SC_PAGESIZE);
+}
+
+// pages left in the hugetlbfs pool of the page size
+int64 Memory::free_huge_pages(int64 page_size) {
+	char path[100];
+	snprintf(path, sizeof(path), "/sys/kernel/mm/hugepages/hugepages-%lldkB/free_hugepages",
+			page_size >> 10);
+	return read_number(path, 0);
+}
+
+// transparent huge pages are available, always or
+// on request, unless the kernel selects [never]
+bool Memory::thp_enabled() {
+	FILE* f = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+	if (f == NULL) {
+		return false;
+	}
+	char line[100] = "";
+	if (fgets(line, sizeof(line), f) == NULL) {
+		line[0] = '\0';
+	}
+	fclose(f);
+
+	return line[0] != '\0' && strstr(line, "[never]") == NULL;
+}
+
+// the bytes of the backing file for each chain,
+// enough for all the memory of the chain
+int64 Memory::slot_size(Experiment &e) {
+	int64 base = sysconf(_SC_PAGESIZE);
+	return (e.bytes_per_region() + base - 1) / base * base;
+}
+
+// create the backing file with a slot for every
+// chain of the test. the file is removed at once,
+// so it goes away with the process, and existing
+// files are never overwritten.
+int Memory::create_file(Experiment &e) {
+	int fd = open(e.backing_file, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd < 0) {
+		printf("chase: cannot create backing file '%s'\n", e.backing_file);
+		return 1;
+	}
+	unlink(e.backing_file);
+
+	int64 size = e.num_threads * e.chains_per_thread * Memory::slot_size(e);
+	if (ftruncate(fd, size) != 0) {
+		printf("chase: cannot size backing file '%s' to %lld bytes\n", e.backing_file, size);
+		close(fd);
+		return 1;
+	}
+	e.backing_fd = fd;
+
+	return 0;
+}
+
+// map the memory with the pages of the experiment,
+// bind it to the domain, then fault it in and lock
+// it as asked. hugetlbfs pages that cannot be had
+// fail under --strict, and fall back to transparent
+// huge pages otherwise. transparent huge pages are
+// aligned so whole huge pages can back them. file
+// backed memory is shared, so the chains live in
+// the page cache of the file.
+void* Memory::map(Experiment &e, int64 bytes, int32 domain, int64 slot) {
+	int64 base = sysconf(_SC_PAGESIZE);
+	int32 pages = e.pages;
+
+	if (0 <= e.backing_fd) {
+		this->fd = e.backing_fd;
+		this->bytes = (bytes + base - 1) / base * base;
+		this->offset = slot * Memory::slot_size(e);
+		this->addr = mmap(NULL, this->bytes, PROT_READ | PROT_WRITE,
+				MAP_SHARED, this->fd, this->offset);
+		if (this->addr == MAP_FAILED) {
+			fprintf(stderr, "Failed to map chain memory from the backing file.\n");
+			exit(1);
+		}
+		if (pages == Experiment::TRANSPARENT_HUGE_PAGES) {
+			madvise(this->addr, this->bytes, MADV_HUGEPAGE);
+		} else if (pages == Experiment::SMALL_PAGES) {
+			madvise(this->addr, this->bytes, MADV_NOHUGEPAGE);
+		}
+		this->bind(domain);
+		this->prefault(e);
+		return this->addr;
+	}
+
+	if (pages == Experiment::HUGE_PAGES_2M || pages == Experiment::HUGE_PAGES_1G) {
+		int64 size = Memory::huge_page_size(pages);
+		int shift = __builtin_ctzll(size);
+		this->bytes = (bytes + size - 1) / size * size;
+		this->addr = mmap(NULL, this->bytes, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (shift << MAP_HUGE_SHIFT), -1, 0);
+		if (this->addr != MAP_FAILED) {
+			this->bind(domain);
+			this->prefault(e);
+			return this->addr;
+		}
+		this->addr = NULL;
+		if (e.strict) {
+			fprintf(stderr, "Failed to allocate chain memory with %s pages.\n", pages_string(pages));
+			exit(1);
+		}
+		pages = Experiment::TRANSPARENT_HUGE_PAGES;
+	}
+
+	int64 align = base;
+	if (pages == Experiment::TRANSPARENT_HUGE_PAGES) {
+		align = Memory::huge_page_size(pages);
+	}
+	this->bytes = (bytes + align - 1) / align * align;
+
+	// map more than needed, then trim the
+	// ends to leave an aligned mapping
+	int64 over = this->bytes + align - base;
+	char* raw = (char*) mmap(NULL, over, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (raw == MAP_FAILED) {
+		fprintf(stderr, "Failed to allocate chain memory.\n");
+		exit(1);
+	}
+	char* start = (char*) (((uint64) raw + align - 1) / align * align);
+	if (raw < start) {
+		munmap(raw, start - raw);
+	}
+	if (start + this->bytes < raw + over) {
+		munmap(start + this->bytes, raw + over - (start + this->bytes));
+	}
+	this->addr = start;
+
+	if (pages == Experiment::TRANSPARENT_HUGE_PAGES) {
+		madvise(this->addr, this->bytes, MADV_HUGEPAGE);
+	} else if (pages == Experiment::SMALL_PAGES) {
+		madvise(this->addr, this->bytes, MADV_NOHUGEPAGE);
+	}
+	this->bind(domain);
+	this->prefault(e);
+
+	return this->addr;
+}
+
+// place the pages of the memory in the domain only,
+// whichever thread touches them first
+void Memory::bind(int32 domain) {
+	this->domain = domain;
+#if defined(NUMA)
+	bitmask* mask = numa_allocate_nodemask();
+	numa_bitmask_setbit(mask, domain);
+	long result = mbind(this->addr, this->bytes, MPOL_BIND, mask->maskp, mask->size + 1, 0);
+	numa_bitmask_free(mask);
+	if (result != 0) {
+		fprintf(stderr, "Failed to bind chain memory to domain %d.\n", domain);
+		exit(1);
+	}
+#endif
+}
+
+// fault the pages in before the chains are built,
+// all at once or by build_threads threads of the
+// domain, and lock them in memory if asked to
+void Memory::prefault(Experiment &e) {
+	char* begin = (char*) this->addr;
+	char* end = begin + this->bytes;
+
+	if (e.prefault == Experiment::POPULATE) {
+#if defined(MADV_POPULATE_WRITE)
+		if (madvise(this->addr, this->bytes, MADV_POPULATE_WRITE) != 0)
+#endif
+			Toucher::touch(begin, end);
+	} else if (e.prefault == Experiment::TOUCH) {
+		int64 step = sysconf(_SC_PAGESIZE);
+		int64 pages = this->bytes / step;
+		int64 count = std::max((int64) 1, std::min(e.build_threads, pages));
+
+		std::vector<Toucher*> helpers;
+		for (int64 k = 1; k < count; k++) {
+			helpers.push_back(new Toucher(begin + pages * k / count * step,
+					begin + pages * (k + 1) / count * step, this->domain));
+			helpers.back()->start();
+		}
+		Toucher::touch(begin, begin + pages / count * step);
+		for (size_t k = 0; k < helpers.size(); k++) {
+			helpers[k]->wait();
+			delete helpers[k];
+		}
+	}
+
+	if (e.lock_memory && mlock(this->addr, this->bytes) != 0) {
+		fprintf(stderr, "Failed to lock chain memory.\n");
+		if (e.strict) {
+			exit(1);
+		}
+	}
+}
+
+void Memory::touch() {
+	Toucher::touch((char*) this->addr, (char*) this->addr + this->bytes);
+}
+
+// drop the pages of the memory, so the next access
+// faults them in again: file pages are written back
+// and dropped from the page cache, anonymous pages
+// are paged out where there is swap
+void Memory::evict() {
+	if (0 <= this->fd) {
+		msync(this->addr, this->bytes, MS_SYNC);
+	}
+#if defined(MADV_PAGEOUT)
+	madvise(this->addr, this->bytes, MADV_PAGEOUT);
+#endif
+	if (0 <= this->fd) {
+		madvise(this->addr, this->bytes, MADV_DONTNEED);
+		posix_fadvise(this->fd, this->offset, this->bytes, POSIX_FADV_DONTNEED);
+	}
+}
+
+// punch the memory out of the backing file, so
+// the next access allocates its pages afresh,
+// like the first access after the file is created
+void Memory::discard() {
+	if (this->fd < 0) {
+		return;
+	}
+	madvise(this->addr, this->bytes, MADV_DONTNEED);
+#if defined(FALLOC_FL_PUNCH_HOLE)
+	fallocate(this->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, this->offset, this->bytes);
+#endif
+}
+
+// count the pages of the memory that are resident,
+// and those of them in the domain it is bound to
+void Memory::placement(int64 &placed, int64 &resident) {
+#if defined(NUMA)
+	const int64 batch = 1024;
+	void* pages[batch];
+	int status[batch];
+
+	int64 step = this->page_size();
+	for (int64 first = 0; first < this->bytes; first += batch * step) {
+		int64 n = 0;
+		for (; n < batch && first + n * step < this->bytes; n++) {
+			pages[n] = (char*) this->addr + first + n * step;
+		}
+		if (move_pages(0, n, pages, NULL, status, 0) != 0) {
+			return;
+		}
+		for (int64 i = 0; i < n; i++) {
+			if (0 <= status[i]) {
+				resident += 1;
+				if (status[i] == this->domain) {
+					placed += 1;
+				}
+			}
+		}
+	}
+#endif
+}
+
+// the page size the kernel reports for the mapping,
+// or the transparent huge page size when those back
+// at least half of its resident memory
+int64 Memory::page_size() {
+	int64 base = sysconf(_SC_PAGESIZE);
+	FILE* f = fopen("/proc/self/smaps", "r");
+	if (f == NULL) {
+		return base;
+	}
+
+	uint64 target = (uint64) this->addr;
+	bool found = false;
+	long long kernel_page = 0, rss = 0, anon_huge = 0;
+	char line[256];
+	while (fgets(line, sizeof(line), f) != NULL) {
+		unsigned long long start, end;
+		if (sscanf(line, "%llx-%llx ", &start, &end) == 2 && strchr(line, '-') < strchr(line, ' ')) {
+			if (found) {
+				break;
+			}
+			found = start <= target && target < end;
+		} else if (found) {
+			sscanf(line, "KernelPageSize: %lld kB", &kernel_page);
+			sscanf(line, "Rss: %lld kB", &rss);
+			sscanf(line, "AnonHugePages: %lld kB", &anon_huge);
+		}
+	}
+	fclose(f);
+
+	if (base < kernel_page << 10) {
+		return kernel_page << 10;
+	}
+	if (0 < anon_huge && rss <= 2 * anon_huge) {
+		return Memory::huge_page_size(Experiment::TRANSPARENT_HUGE_PAGES);
+	}
+	return base;
+}
@@ -0,0 +1,68 @@
+/*******************************************************************************
+ * Copyright (c) 2006 International Business Machines Corporation.             *
+ * All rights reserved. This program and the accompanying materials            *
+ * are made available under the terms of the Common Public License v1.0        *
+ * which accompanies this distribution, and is available at                    *
+ * http://www.opensource.org/licenses/cpl1.0.php                               *
+ *                                                                             *
+ * Contributors:                                                               *
+ *    Douglas M. Pase - initial API and implementation                         *
+ *    Tim Besard - prefetching, JIT compilation                                *
+ *******************************************************************************/
+
+//
+// Configuration
+//
+
+// Include guard
+#if !defined(MEMORY_H)
+#define MEMORY_H
+
+// Local includes
+#include "types.h"
+#include "experiment.h"
+
+
+//
+// Class definition
+//
+
+// memory of one chain, mapped with the pages the
+// experiment asks for and bound to its numa domain,
+// anonymous or from its own slot of the backing file
+class Memory {
+public:
+	Memory();
+	~Memory();
+
+	void* map(Experiment &e, int64 bytes, int32 domain, int64 slot);
+	void* base() {
+		return this->addr;
+	}
+	int64 size() {
+		return this->bytes;
+	}
+	int64 page_size();	// size of the pages backing most of the memory
+	void placement(int64 &placed, int64 &resident);
+	void touch();		// write a byte of every page
+	void evict();		// drop the pages from memory
+	void discard();		// free the blocks of the backing file
+
+	static int64 huge_page_size(int32 pages);
+	static int64 free_huge_pages(int64 page_size);
+	static bool thp_enabled();
+	static int64 slot_size(Experiment &e);
+	static int create_file(Experiment &e);
+
+private:
+	void bind(int32 domain);
+	void prefault(Experiment &e);
+
+	void* addr;		// start of the memory
+	int64 bytes;	// bytes mapped
+	int32 domain;	// numa domain the memory is bound to
+	int fd;			// backing file, or -1 for anonymous memory
+	int64 offset;	// offset of the memory in the backing file
+};
+
+#endif
@@ -0,0 +1,249 @@
+/*******************************************************************************
+ * Copyright (c) 2006 International Business Machines Corporation.             *
+ * All rights reserved. This program and the accompanying materials            *
+ * are made available under the terms of the Common Public License v1.0        *
+ * which accompanies this distribution, and is available at                    *
+ * http://www.opensource.org/licenses/cpl1.0.php                               *
+ *                                                                             *
+ * Contributors:                                                               *
+ *    Douglas M. Pase - initial API and implementation                         *
+ *    Tim Besard - prefetching, JIT compilation                                *
+ *******************************************************************************/
+
+//
+// Configuration
+//
+
+// Implementation header
+#include "native.h"
+
+// System includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+
+
+//
+// Implementation
+//
+
+/*
+ * The native benchmark is plain C++, specialised at compile time on the
+ * memory operation, the number of chains and the unroll factor, so the
+ * loop over the chains and the unrolled links is flattened by the compiler
+ * and the positions stay in registers, just like in the JIT kernel. All
+ * accesses go through volatile links so none of them can be optimised away.
+ *
+ * The remaining parameters (lines touched, prefetch hint and loop length)
+ * are the same for every benchmark of the experiment and invariant for the
+ * whole run, so the branches on them are always predicted correctly. Only
+ * experiments that prefetch or work get kernels with these branches.
+ */
+
+// vector moved by the *_line operations, unaligned
+// as the links may sit at any offset of their lines
+typedef uint64_t Vector __attribute__ ((vector_size (16), aligned (1)));
+
+struct Params {
+	int64 lines;			// lines touched by the *_all and *_line operations
+	int64 bytes_per_line;
+	int64 link_size;		// bytes of the link, kept by store_line
+	int64 loop_length;
+	int32 work;
+	int32 prefetch_hint;
+};
+
+static Params params;
+
+// execute the work of one iteration, the empty asm
+// keeps the compiler from folding the additions. the
+// nops are issued in unrolled blocks, like the
+// straight-line nops of the JIT kernel.
+static inline __attribute__ ((always_inline)) void work(const Params &p) {
+	uint64_t a = 0, b = 0, c = 0, d = 0;
+	int64 i = 0;
+
+	switch (p.work) {
+	case Experiment::DEPENDENT:
+		for (; i < p.loop_length; i++) {
+			a += 1;
+			__asm__ __volatile__("" : "+r"(a));
+		}
+		break;
+	case Experiment::INDEPENDENT:
+		for (; i + 4 <= p.loop_length; i += 4) {
+			a += 1; b += 1; c += 1; d += 1;
+			__asm__ __volatile__("" : "+r"(a), "+r"(b), "+r"(c), "+r"(d));
+		}
+		for (; i < p.loop_length; i++) {
+			a += 1;
+			__asm__ __volatile__("" : "+r"(a));
+		}
+		break;
+	default:
+		for (; i + 8 <= p.loop_length; i += 8)
+			__asm__ __volatile__(".rept 8\n\tnop\n\t.endr");
+		for (; i < p.loop_length; i++)
+			__asm__ __volatile__("nop");
+		break;
+	}
+}
+
+template<int OPERATION>
+static inline __attribute__ ((always_inline)) Chain* hop(Chain* position, const Params &p) {
+	// chase pointer
+	volatile Chain* link = ((volatile Chain*) position)->next;
+
+	if (OPERATION == Experiment::LOAD) {
+		(void) link->data;
+	} else if (OPERATION == Experiment::STORE) {
+		link->data = 0;
+	} else if (OPERATION == Experiment::LOAD_ALL) {
+		for (int64 j = 0; j < p.lines; j++)
+			(void) ((volatile Chain*) ((volatile char*) link + j*p.bytes_per_line))->data;
+	} else if (OPERATION == Experiment::STORE_ALL) {
+		for (int64 j = 0; j < p.lines; j++)
+			((volatile Chain*) ((volatile char*) link + j*p.bytes_per_line))->data = 100 * j;
+	} else if (OPERATION == Experiment::LOAD_LINE) {
+		for (int64 j = 0; j < p.lines * p.bytes_per_line; j += sizeof(Vector))
+			(void) *(volatile Vector*) ((volatile char*) link + j);
+	} else if (OPERATION == Experiment::STORE_LINE) {
+		for (int64 j = 0; j < p.lines * p.bytes_per_line; j += sizeof(Vector)) {
+			volatile Vector* v = (volatile Vector*) ((volatile char*) link + j);
+			if (j < p.link_size) {
+				// write the link back as it is
+				*v = *v;
+			} else {
+				*v = Vector {};
+			}
+		}
+	}
+
+	return (Chain*) link;
+}
+
+// prefetch the links ahead of all chains. the hint
+// must be a constant, so the choice is made once
+// per round rather than once per link.
+template<int CHAINS>
+static inline __attribute__ ((always_inline)) void prefetch(Chain** positions, int32 hint) {
+	switch (hint) {
+	case Experiment::T0:
+#pragma GCC unroll 16
+		for (int i = 0; i < CHAINS; i++)
+			__builtin_prefetch(((volatile Lookahead*) positions[i])->ahead, 0, 3);
+		break;
+	case Experiment::T1:
+#pragma GCC unroll 16
+		for (int i = 0; i < CHAINS; i++)
+			__builtin_prefetch(((volatile Lookahead*) positions[i])->ahead, 0, 2);
+		break;
+	case Experiment::T2:
+#pragma GCC unroll 16
+		for (int i = 0; i < CHAINS; i++)
+			__builtin_prefetch(((volatile Lookahead*) positions[i])->ahead, 0, 1);
+		break;
+	case Experiment::NTA:
+#pragma GCC unroll 16
+		for (int i = 0; i < CHAINS; i++)
+			__builtin_prefetch(((volatile Lookahead*) positions[i])->ahead, 0, 0);
+		break;
+	default:
+		break;
+	}
+}
+
+// the prefetch and the work after every round are
+// only compiled into the EXTRAS kernels, so the
+// plain chase has nothing but the hops in its loop
+template<int OPERATION, int CHAINS, int UNROLL, bool EXTRAS>
+static void chase(Chain** root, int64 count) {
+	const Params p = params;
+	const int32 hint = p.prefetch_hint;
+
+	Chain* positions[CHAINS];
+#pragma GCC unroll 16
+	for (int i = 0; i < CHAINS; i++)
+		positions[i] = root[i];
+
+	for (int64 n = 0; n < count; n++) {
+#pragma GCC unroll 8
+		for (int u = 0; u < UNROLL; u++) {
+#pragma GCC unroll 16
+			for (int i = 0; i < CHAINS; i++)
+				positions[i] = hop<OPERATION>(positions[i], p);
+
+			if (EXTRAS) {
+				prefetch<CHAINS>(positions, hint);
+
+				// wait
+				work(p);
+			}
+		}
+	}
+}
+
+// benchmarks indexed by [chains - 1][log2(unroll)][extras]
+typedef benchmark Table[NATIVE_MAX_CHAINS][4][2];
+
+template<int OPERATION, int CHAINS>
+struct Fill {
+	static void table(Table &t) {
+		Fill<OPERATION, CHAINS - 1>::table(t);
+		t[CHAINS - 1][0][0] = chase<OPERATION, CHAINS, 1, false>;
+		t[CHAINS - 1][1][0] = chase<OPERATION, CHAINS, 2, false>;
+		t[CHAINS - 1][2][0] = chase<OPERATION, CHAINS, 4, false>;
+		t[CHAINS - 1][3][0] = chase<OPERATION, CHAINS, 8, false>;
+		t[CHAINS - 1][0][1] = chase<OPERATION, CHAINS, 1, true>;
+		t[CHAINS - 1][1][1] = chase<OPERATION, CHAINS, 2, true>;
+		t[CHAINS - 1][2][1] = chase<OPERATION, CHAINS, 4, true>;
+		t[CHAINS - 1][3][1] = chase<OPERATION, CHAINS, 8, true>;
+	}
+};
+
+template<int OPERATION>
+struct Fill<OPERATION, 0> {
+	static void table(Table &) {
+	}
+};
+
+// cache maintenance and non-temporal stores
+// have no portable equivalent
+bool native_supports(int32 operation) {
+	return operation <= Experiment::STORE_LINE;
+}
+
+benchmark native_chase_pointers(Experiment &exp) {
+	static Table tables[Experiment::STORE_LINE + 1];
+	static bool filled = false;
+	if (!filled) {
+		Fill<Experiment::NA, NATIVE_MAX_CHAINS>::table(tables[Experiment::NA]);
+		Fill<Experiment::LOAD, NATIVE_MAX_CHAINS>::table(tables[Experiment::LOAD]);
+		Fill<Experiment::STORE, NATIVE_MAX_CHAINS>::table(tables[Experiment::STORE]);
+		Fill<Experiment::LOAD_ALL, NATIVE_MAX_CHAINS>::table(tables[Experiment::LOAD_ALL]);
+		Fill<Experiment::STORE_ALL, NATIVE_MAX_CHAINS>::table(tables[Experiment::STORE_ALL]);
+		Fill<Experiment::LOAD_LINE, NATIVE_MAX_CHAINS>::table(tables[Experiment::LOAD_LINE]);
+		Fill<Experiment::STORE_LINE, NATIVE_MAX_CHAINS>::table(tables[Experiment::STORE_LINE]);
+		filled = true;
+	}
+
+	int log2_unroll = 0;
+	while ((1 << log2_unroll) < exp.unroll)
+		log2_unroll++;
+	if (!native_supports(exp.mem_operation)
+			|| exp.chains_per_thread < 1 || NATIVE_MAX_CHAINS < exp.chains_per_thread
+			|| NATIVE_MAX_UNROLL < exp.unroll || (1 << log2_unroll) != exp.unroll) {
+		printf("Error selecting native function (unsupported parameters).\n");
+		return 0;
+	}
+
+	params.lines = exp.lines_per_op();
+	params.bytes_per_line = exp.bytes_per_line;
+	params.link_size = exp.pointer_size;
+	params.loop_length = exp.loop_length;
+	params.work = exp.work;
+	params.prefetch_hint = exp.prefetch_hint;
+
+	bool extras = exp.prefetch_hint != Experiment::NONE || 0 < exp.loop_length;
+	return tables[exp.mem_operation][exp.chains_per_thread - 1][log2_unroll][extras];
+}
@@ -0,0 +1,41 @@
+/*******************************************************************************
+ * Copyright (c) 2006 International Business Machines Corporation.             *
+ * All rights reserved. This program and the accompanying materials            *
+ * are made available under the terms of the Common Public License v1.0        *
+ * which accompanies this distribution, and is available at                    *
+ * http://www.opensource.org/licenses/cpl1.0.php                               *
+ *                                                                             *
+ * Contributors:                                                               *
+ *    Douglas M. Pase - initial API and implementation                         *
+ *    Tim Besard - prefetching, JIT compilation                                *
+ *******************************************************************************/
+
+//
+// Configuration
+//
+
+// Include guard
+#if !defined(NATIVE_H)
+#define NATIVE_H
+
+// Local includes
+#include "kernel.h"
+#include "experiment.h"
+
+
+//
+// Function definitions
+//
+
+// largest number of chains per thread and unroll
+// factor the native benchmark is specialised for
+const int NATIVE_MAX_CHAINS = 16;
+const int NATIVE_MAX_UNROLL = 8;
+
+// whether the native benchmark implements an operation
+bool native_supports(int32 operation);
+
+// select the compiled benchmark matching the experiment
+benchmark native_chase_pointers(Experiment &exp);
+
+#endif
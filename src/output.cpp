@@ -27,6 +27,15 @@
 // Implementation
 //
 
+// the chains each thread works on, only the
+// arrays of the STREAM kernels even when a numa
+// map gives the threads more chains
+static int64 chains_worked(Experiment &e) {
+	if (e.is_stream())
+		return e.stream_arrays();
+	return e.chains_per_thread;
+}
+
 void Output::print(Experiment &e, int64 ops, std::vector<double> seconds, double ck_res) {
 	if (e.output_mode == Experiment::HEADER) {
 		Output::header(e, ops, ck_res);
@@ -55,16 +64,33 @@ void Output::header(Experiment &e, int64 ops, double ck_res) {
     printf("chains per thread,");
     printf("number of threads,");
     printf("iterations,");
+    printf("kernel,");
     printf("loop length,");
+    printf("work,");
+    printf("unroll,");
     printf("prefetch hint,");
+    printf("prefetch distance,");
     printf("memory operation,");
+    printf("memory order,");
     printf("experiments,");
     printf("access pattern,");
     printf("stride,");
+    printf("window (bytes),");
+    printf("zipf theta,");
+    printf("link offset (bytes),");
+    printf("split,");
+    printf("pages,");
+    printf("backing page size (bytes),");
+    printf("prefault,");
+    printf("mlock,");
+    printf("backing,");
+    printf("cold,");
     printf("numa placement,");
     printf("offset or mask,");
     printf("numa domains,");
+    printf("seed,");
     printf("domain map,");
+    printf("pages in domain (%%),");
     printf("operations per chain,");
     printf("total operations,");
     printf("elapsed time (seconds),");
@@ -86,15 +112,40 @@ void Output::csv(Experiment &e, int64 ops, double secs, double ck_res) {
     printf("%lld,", e.chains_per_thread);
     printf("%lld,", e.num_threads);
     printf("%lld,", e.iterations);
+    printf("%s,", kernel_string(e.kernel));
     printf("%lld,", e.loop_length);
+    printf("%s,", work_string(e.work));
+    printf("%lld,", e.unroll);
     printf("%s,", prefetch_hint_string(e.prefetch_hint));
-    printf("%s,", operation_string(e.mem_operation));
+    printf("%lld,", e.prefetch_distance);
+    if (e.mem_operation == Experiment::MIX)
+        printf("mix:%lld,", e.read_percent);
+    else
+        printf("%s,", operation_string(e.mem_operation));
+    printf("%s,", memory_order_string(e.memory_order));
     printf("%lld,", e.experiments);
     printf("%s,", e.access());
     printf("%lld,", e.stride);
+    printf("%lld,", e.window);
+    printf("%.3f,", e.zipf_theta);
+    if (e.random_offset)
+        printf("random,");
+    else
+        printf("%lld,", e.link_offset);
+    printf("%s,", split_string(e.split));
+    printf("%s,", pages_string(e.pages));
+    printf("%lld,", e.backing_page_size);
+    printf("%s,", prefault_string(e.prefault));
+    printf("%s,", e.lock_memory ? "yes" : "no");
+    if (e.backing_file != NULL)
+        printf("\"file:%s\",", e.backing_file);
+    else
+        printf("anon,");
+    printf("%s,", e.cold ? "yes" : "no");
     printf("%s,", e.placement());
     printf("%lld,", e.offset_or_mask);
     printf("%d,", e.num_numa_domains);
+    printf("%llu,", e.seed);
     printf("\"");
     printf("%d:", e.thread_domain[0]);
     printf("%d", e.chain_domain[0][0]);
@@ -109,14 +160,17 @@ void Output::csv(Experiment &e, int64 ops, double secs, double ck_res) {
 		}
 	}
     printf("\",");
+    if (0 < e.pages_resident)
+        printf("%.2f,", 100.0 * e.pages_placed / e.pages_resident);
+    else
+        printf("n/a,");
     printf("%lld,", ops);
-    printf("%lld,", ops * e.chains_per_thread * e.num_threads);
+    printf("%lld,", ops * chains_worked(e) * e.num_threads);
     printf("%.3f,", secs);
     printf("%.0f,", secs/ck_res);
     printf("%.2f,", ck_res * 1E9);
-    printf("%.2f,", (secs / (ops * e.iterations)) * 1E9);
-    uint32_t line_num=e.mem_operation==Experiment::STORE_ALL||e.mem_operation==Experiment::LOAD_ALL?abs(e.stride):1;
-    printf("%.3f\n", ((ops * e.iterations * e.chains_per_thread * e.num_threads * e.bytes_per_line * line_num) / secs) * 1E-6);
+    printf("%.2f,", (secs / e.hops(ops, e.iterations)) * 1E9);
+    printf("%.3f\n", ((e.hops(ops, e.iterations) * chains_worked(e) * e.num_threads * e.bytes_per_op()) / secs) * 1E-6);
 
     fflush(stdout);
 }
@@ -131,15 +185,40 @@ void Output::table(Experiment &e, int64 ops, double secs, double ck_res) {
     printf("chains per thread    = %lld\n", e.chains_per_thread);
     printf("number of threads    = %lld\n", e.num_threads);
     printf("iterations           = %lld\n", e.iterations);
+    printf("kernel               = %s\n", kernel_string(e.kernel));
     printf("loop length          = %lld\n", e.loop_length);
+    printf("work                 = %s\n", work_string(e.work));
+    printf("unroll               = %lld\n", e.unroll);
     printf("prefetch hint        = %s\n", prefetch_hint_string(e.prefetch_hint));
-    printf("memory operation     = %s\n", operation_string(e.mem_operation));
+    printf("prefetch distance    = %lld\n", e.prefetch_distance);
+    if (e.mem_operation == Experiment::MIX)
+        printf("memory operation     = mix:%lld\n", e.read_percent);
+    else
+        printf("memory operation     = %s\n", operation_string(e.mem_operation));
+    printf("memory order         = %s\n", memory_order_string(e.memory_order));
     printf("experiments          = %lld\n", e.experiments);
     printf("access pattern       = %s\n", e.access());
     printf("stride               = %lld\n", e.stride);
+    printf("window               = %lld (bytes)\n", e.window);
+    printf("zipf theta           = %.3f\n", e.zipf_theta);
+    if (e.random_offset)
+        printf("link offset          = random\n");
+    else
+        printf("link offset          = %lld (bytes)\n", e.link_offset);
+    printf("split                = %s\n", split_string(e.split));
+    printf("pages                = %s\n", pages_string(e.pages));
+    printf("backing page size    = %lld (bytes)\n", e.backing_page_size);
+    printf("prefault             = %s\n", prefault_string(e.prefault));
+    printf("mlock                = %s\n", e.lock_memory ? "yes" : "no");
+    if (e.backing_file != NULL)
+        printf("backing              = file:%s\n", e.backing_file);
+    else
+        printf("backing              = anon\n");
+    printf("cold                 = %s\n", e.cold ? "yes" : "no");
     printf("numa placement       = %s\n", e.placement());
     printf("offset or mask       = %lld\n", e.offset_or_mask);
     printf("numa domains         = %d\n", e.num_numa_domains);
+    printf("seed                 = %llu\n", e.seed);
     printf("domain map           = ");
     printf("\"");
     printf("%d:", e.thread_domain[0]);
@@ -155,14 +234,126 @@ void Output::table(Experiment &e, int64 ops, double secs, double ck_res) {
 		}
 	}
     printf("\"\n");
+    if (0 < e.pages_resident)
+        printf("pages in domain      = %.2f (%%)\n", 100.0 * e.pages_placed / e.pages_resident);
+    else
+        printf("pages in domain      = n/a\n");
     printf("operations per chain = %lld\n", ops);
-    printf("total operations     = %lld\n", ops * e.chains_per_thread * e.num_threads);
+    printf("total operations     = %lld\n", ops * chains_worked(e) * e.num_threads);
     printf("elapsed time         = %.3f (seconds)\n", secs);
     printf("elapsed time         = %.0f (timer ticks)\n", secs/ck_res);
     printf("clock resolution     = %.2f (ns)\n", ck_res * 1E9);
-    printf("memory latency       = %.2f (ns)\n", (secs / (ops * e.iterations)) * 1E9);
-    uint32_t line_num=e.mem_operation==Experiment::STORE_ALL||e.mem_operation==Experiment::LOAD_ALL?abs(e.stride):1;
-    printf("memory bandwidth     = %.3f (MB/s)\n", ((ops * e.iterations * e.chains_per_thread * e.num_threads * e.bytes_per_line * line_num) / secs) * 1E-6);
+    printf("memory latency       = %.2f (ns)\n", (secs / e.hops(ops, e.iterations)) * 1E9);
+    printf("memory bandwidth     = %.3f (MB/s)\n", ((e.hops(ops, e.iterations) * chains_worked(e) * e.num_threads * e.bytes_per_op()) / secs) * 1E-6);
+
+    fflush(stdout);
+}
+
+// one row per step of the sweep, step k chasing k chains.
+// latency is the time between hops of one chain, and by
+// Little's law the misses outstanding per thread are the
+// references per second times the latency of a single chain
+void Output::mlp(Experiment &e, int64 ops, std::vector<int64> iterations,
+		std::vector<double> seconds) {
+	if (e.output_mode == Experiment::TABLE) {
+		printf("chains  iterations  latency (ns)  bandwidth (MB/s)  outstanding misses\n");
+	} else if (e.output_mode != Experiment::CSV) {
+		printf("chains per thread,");
+		printf("number of threads,");
+		printf("iterations,");
+		printf("elapsed time (seconds),");
+		printf("memory latency (ns),");
+		printf("memory bandwidth (MB/s),");
+		printf("outstanding misses\n");
+	}
+	if (e.output_mode == Experiment::HEADER) {
+		fflush(stdout);
+		return;
+	}
+
+	double single = 0;
+	for (size_t i = 0; i < seconds.size(); i++) {
+		int64 chains = i + 1;
+		double latency = seconds[i] / e.hops(ops, iterations[i]);
+		double bandwidth = (e.hops(ops, iterations[i]) * chains * e.num_threads * e.bytes_per_op()) / seconds[i];
+		if (i == 0)
+			single = latency;
+		double outstanding = chains * single / latency;
+
+		if (e.output_mode == Experiment::TABLE) {
+			printf("%6lld  %10lld  %12.2f  %16.3f  %18.2f\n", chains, iterations[i],
+					latency * 1E9, bandwidth * 1E-6, outstanding);
+		} else {
+			printf("%lld,", chains);
+			printf("%lld,", e.num_threads);
+			printf("%lld,", iterations[i]);
+			printf("%.3f,", seconds[i]);
+			printf("%.2f,", latency * 1E9);
+			printf("%.3f,", bandwidth * 1E-6);
+			printf("%.2f\n", outstanding);
+		}
+	}
+
+    fflush(stdout);
+}
+
+// one row per number of threads faulting at once, each
+// faulting pages per chain. the speedup is the rate of
+// page faults relative to that of a single thread
+void Output::fault(Experiment &e, int64 pages, std::vector<double> seconds) {
+	if (e.output_mode == Experiment::TABLE) {
+		printf("threads  faults per thread  elapsed (s)  faults per second  bandwidth (GB/s)  speedup\n");
+	} else if (e.output_mode != Experiment::CSV) {
+		printf("pages,");
+		printf("backing page size (bytes),");
+		printf("numa placement,");
+		printf("backing,");
+		printf("cold,");
+		printf("chain size (bytes),");
+		printf("chains per thread,");
+		printf("number of threads,");
+		printf("faults per thread,");
+		printf("elapsed time (seconds),");
+		printf("faults per second,");
+		printf("bandwidth (GB/s),");
+		printf("speedup\n");
+	}
+	if (e.output_mode == Experiment::HEADER) {
+		fflush(stdout);
+		return;
+	}
+
+	double single = 0;
+	for (size_t i = 0; i < seconds.size(); i++) {
+		int64 threads = i + 1;
+		int64 faults = pages * e.chains_per_thread;
+		double rate = faults * threads / seconds[i];
+		double bandwidth = rate * e.backing_page_size;
+		if (i == 0)
+			single = rate;
+
+		if (e.output_mode == Experiment::TABLE) {
+			printf("%7lld  %17lld  %11.3f  %17.0f  %16.3f  %7.2f\n", threads, faults,
+					seconds[i], rate, bandwidth * 1E-9, rate / single);
+		} else {
+			printf("%s,", pages_string(e.pages));
+			printf("%lld,", e.backing_page_size);
+			printf("%s,", e.placement());
+			if (e.backing_file != NULL)
+				printf("\"file:%s\",", e.backing_file);
+			else
+				printf("anon,");
+			printf("%s,", e.cold ? "yes" : "no");
+			printf("%lld,", e.bytes_per_chain);
+			printf("%lld,", e.chains_per_thread);
+			printf("%lld,", threads);
+			printf("%lld,", faults);
+			printf("%.6f,", seconds[i]);
+			printf("%.0f,", rate);
+			printf("%.3f,", bandwidth * 1E-9);
+			printf("%.2f\n", rate / single);
+		}
+	}
 
     fflush(stdout);
 }
@@ -36,6 +36,9 @@ public:
 	static void header(Experiment &e, int64 ops, double ck_res);
 	static void csv(Experiment &e, int64 ops, double seconds, double ck_res);
 	static void table(Experiment &e, int64 ops, double seconds, double ck_res);
+	static void mlp(Experiment &e, int64 ops, std::vector<int64> iterations,
+			std::vector<double> seconds);
+	static void fault(Experiment &e, int64 pages, std::vector<double> seconds);
 private:
 };
 
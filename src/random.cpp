@@ -0,0 +1,79 @@
+/*******************************************************************************
+ * Copyright (c) 2006 International Business Machines Corporation.             *
+ * All rights reserved. This program and the accompanying materials            *
+ * are made available under the terms of the Common Public License v1.0        *
+ * which accompanies this distribution, and is available at                    *
+ * http://www.opensource.org/licenses/cpl1.0.php                               *
+ *                                                                             *
+ * Contributors:                                                               *
+ *    Douglas M. Pase - initial API and implementation                         *
+ *    Tim Besard - prefetching, JIT compilation                                *
+ *******************************************************************************/
+
+//
+// Configuration
+//
+
+// Implementation header
+#include "random.h"
+
+
+//
+// Implementation
+//
+
+static inline uint64 rotl(uint64 x, int k) {
+	return (x << k) | (x >> (64 - k));
+}
+
+// splitmix64, which expands a seed
+// into a well mixed generator state
+static inline uint64 splitmix(uint64 &x) {
+	uint64 z = (x += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+// a well mixed function of key and x,
+// for values drawn without a sequence
+uint64 Random::hash(uint64 key, uint64 x) {
+	uint64 z = key ^ splitmix(x);
+	return splitmix(z);
+}
+
+Random::Random() {
+	this->seed(0, 0);
+}
+
+// each stream (thread) of a seed gets its own
+// sequence, the same on every run and host
+void Random::seed(uint64 seed, uint64 stream) {
+	uint64 x = seed ^ splitmix(stream);
+	for (int i = 0; i < 4; i++)
+		this->s[i] = splitmix(x);
+}
+
+uint64 Random::next() {
+	const uint64 result = rotl(this->s[1] * 5, 7) * 9;
+	const uint64 t = this->s[1] << 17;
+
+	this->s[2] ^= this->s[0];
+	this->s[3] ^= this->s[1];
+	this->s[1] ^= this->s[2];
+	this->s[0] ^= this->s[3];
+	this->s[2] ^= t;
+	this->s[3] = rotl(this->s[3], 45);
+
+	return result;
+}
+
+// uniform in [0, bound), rejecting the
+// draws that would bias the remainder
+uint64 Random::below(uint64 bound) {
+	uint64 limit = -bound % bound;
+	uint64 r = this->next();
+	while (r < limit)
+		r = this->next();
+	return r % bound;
+}
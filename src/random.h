@@ -0,0 +1,43 @@
+/*******************************************************************************
+ * Copyright (c) 2006 International Business Machines Corporation.             *
+ * All rights reserved. This program and the accompanying materials            *
+ * are made available under the terms of the Common Public License v1.0        *
+ * which accompanies this distribution, and is available at                    *
+ * http://www.opensource.org/licenses/cpl1.0.php                               *
+ *                                                                             *
+ * Contributors:                                                               *
+ *    Douglas M. Pase - initial API and implementation                         *
+ *    Tim Besard - prefetching, JIT compilation                                *
+ *******************************************************************************/
+
+//
+// Configuration
+//
+
+// Include guard
+#if !defined(RANDOM_H)
+#define RANDOM_H
+
+// Local includes
+#include "types.h"
+
+
+//
+// Class definition
+//
+
+// xoshiro256** generator, one per thread so
+// no lock is needed to draw random numbers
+class Random {
+public:
+	Random();
+	void seed(uint64 seed, uint64 stream);
+	uint64 next();
+	uint64 below(uint64 bound);
+	static uint64 hash(uint64 key, uint64 x);
+
+private:
+	uint64 s[4];
+};
+
+#endif
@@ -23,29 +23,35 @@
 #include <unistd.h>
 #include <cstddef>
 #include <algorithm>
+#include <cmath>
 #if defined(NUMA)
 #include <numa.h>
 #endif
 
 // Local includes
-#include <asmjit/core.h>
-#include <asmjit/a64.h>
+#include "kernel.h"
+#include "stream.h"
 #include "timer.h"
+#include "trace.h"
+#include "layout.h"
+#include "memory.h"
 
 
 //
 // Implementation
 //
 
-typedef void (*benchmark)(Chain**);
-static benchmark chase_pointers(asmjit::JitRuntime &rt,	Experiment &exp);
-
 Lock Run::global_mutex;
 int64 Run::_ops_per_chain = 0;
+int64 Run::_skipped_hops = 0;
+std::vector<uint64> Run::_chain_links;
 std::vector<double> Run::_seconds;
+std::vector<int64> Run::_mlp_iterations;
+std::vector<double> Run::_mlp_seconds;
+std::vector<double> Run::_fault_seconds;
 
 Run::Run() :
-		exp(NULL), bp(NULL) {
+		exp(NULL), bp(NULL), regions(NULL), region_count(0) {
 }
 
 Run::~Run() {
@@ -57,11 +63,32 @@ void Run::set(Experiment &e, SpinBarrier* sbp) {
 }
 
 int Run::run() {
+	if (this->exp->kernel == Experiment::FAULT) {
+		return this->fault();
+	}
+
+	// the sweep below changes the number of
+	// chains the experiment chases, so keep
+	// the number of chains allocated
+	int64 chains = this->exp->chains_per_thread;
+
+	// the layouts only depend on the
+	// seed and the thread, not the host
+	this->rng.seed(this->exp->seed, this->thread_id());
+
 	// first allocate all memory for the chains,
 	// making sure it is allocated within the
 	// intended numa domains
-	Chain** chain_memory = new Chain*[this->exp->chains_per_thread];
-	Chain** root = new Chain*[this->exp->chains_per_thread];
+	// chains are aligned to the page size, so links
+	// start on hardware cache line boundaries, which
+	// the cache maintenance operations rely on. the
+	// chains get a spare line at the end, for the
+	// links offset into or across the next line.
+	this->regions = new Memory[chains];
+	this->region_count = chains;
+	Chain** chain_memory = new Chain*[chains];
+	Chain** root = new Chain*[chains];
+	int64 bytes = this->exp->bytes_per_region();
 
 #if defined(NUMA)
 	// establish the node id where this thread
@@ -70,42 +97,242 @@ int Run::run() {
 	int run_node_id = this->exp->thread_domain[this->thread_id()];
 	numa_run_on_node(run_node_id);
 
+	// compile the benchmarks once per node
+	std::vector<benchmark> benches = this->kernels(run_node_id);
+
 	// establish the node id where this thread's
 	// memory will be allocated.
-	for (int i=0; i < this->exp->chains_per_thread; i++) {
+	for (int i=0; i < chains; i++) {
 		int alloc_node_id = this->exp->chain_domain[this->thread_id()][i];
-        bitmask* alloc_mask = numa_allocate_nodemask();
-   		numa_bitmask_setbit(alloc_mask, alloc_node_id);
-    	numa_set_membind(alloc_mask);
-    	numa_bitmask_free(alloc_mask);
-
-		chain_memory[i] = new Chain[ this->exp->links_per_chain ];
+		chain_memory[i] = (Chain*) this->regions[i].map(*this->exp, bytes, alloc_node_id,
+				this->thread_id() * chains + i);
 	}
 #else
-	for (int i = 0; i < this->exp->chains_per_thread; i++) {
-		chain_memory[i] = new Chain[this->exp->links_per_chain];
+	// compile the benchmarks once for all threads
+	std::vector<benchmark> benches = this->kernels(0);
+
+	for (int i = 0; i < chains; i++) {
+		chain_memory[i] = (Chain*) this->regions[i].map(*this->exp, bytes, 0,
+				this->thread_id() * chains + i);
 	}
 #endif
+	for (size_t i = 0; i < benches.size(); i++) {
+		if (benches[i] == 0) {
+			::exit(1);
+		}
+	}
 
 	// initialize the chains and
 	// select the function that
 	// will generate the tests
-	for (int i = 0; i < this->exp->chains_per_thread; i++) {
-		if (this->exp->access_pattern == Experiment::RANDOM) {
-			root[i] = random_mem_init(chain_memory[i]);
-		} else if (this->exp->access_pattern == Experiment::STRIDED) {
-			if (0 < this->exp->stride) {
-				root[i] = forward_mem_init(chain_memory[i]);
-			} else {
-				root[i] = reverse_mem_init(chain_memory[i]);
+	if (this->exp->is_stream()) {
+		stream_init(chain_memory, *this->exp);
+		for (int i = 0; i < chains; i++) {
+			root[i] = chain_memory[i];
+		}
+		Run::global_mutex.lock();
+		Run::_ops_per_chain = this->exp->bytes_per_chain / sizeof(double);
+		Run::global_mutex.unlock();
+	} else {
+		for (int i = 0; i < chains; i++) {
+			int32 domain = 0;
+#if defined(NUMA)
+			// the helpers building the chain
+			// run in the chain's domain
+			domain = this->exp->chain_domain[this->thread_id()][i];
+#endif
+			if (this->exp->layout != NULL) {
+				root[i] = load_mem_init(chain_memory[i], i);
+			} else if (this->exp->access_pattern == Experiment::RANDOM) {
+				root[i] = random_mem_init(chain_memory[i], domain);
+			} else if (this->exp->access_pattern == Experiment::WINDOW) {
+				root[i] = window_mem_init(chain_memory[i], domain);
+			} else if (this->exp->access_pattern == Experiment::ZIPF) {
+				root[i] = zipf_mem_init(chain_memory[i]);
+			} else if (this->exp->access_pattern == Experiment::TRACE) {
+				root[i] = trace_mem_init(chain_memory[i]);
+			} else if (this->exp->access_pattern == Experiment::RANDOM_FULL) {
+				root[i] = random_full_mem_init(chain_memory[i]);
+			} else if (this->exp->access_pattern == Experiment::STRIDED) {
+				if (0 < this->exp->stride) {
+					root[i] = forward_mem_init(chain_memory[i], domain);
+				} else {
+					root[i] = reverse_mem_init(chain_memory[i], domain);
+				}
 			}
 		}
+
+		if (this->exp->save_file != NULL) {
+			this->save_mem(chain_memory, root);
+		}
 	}
 
-	// compile benchmark
-	asmjit::JitRuntime rt;
-	benchmark bench = chase_pointers(rt, *this->exp);
+	// the pages backing the chains, and their
+	// domains, are known once they are touched
+	int64 page_size = this->regions[0].page_size();
+	int64 placed = 0, resident = 0;
+	for (int i = 0; i < chains; i++) {
+		page_size = std::min(page_size, this->regions[i].page_size());
+		this->regions[i].placement(placed, resident);
+	}
+	Run::global_mutex.lock();
+	if (this->exp->backing_page_size == 0 || page_size < this->exp->backing_page_size) {
+		this->exp->backing_page_size = page_size;
+	}
+	this->exp->pages_placed += placed;
+	this->exp->pages_resident += resident;
+	Run::global_mutex.unlock();
+
+	// the compare and swap only succeeds
+	// (and so only stores) on zeroed data
+	if (this->exp->mem_operation == Experiment::CAS && !this->exp->is_stream()) {
+		for (int i = 0; i < chains; i++) {
+			this->data_init(root[i]);
+		}
+	}
 
+	if (this->exp->mlp) {
+		// every thread must have read the
+		// experiment before the sweep changes it
+		int64 iterations = this->exp->iterations;
+		this->bp->barrier();
+
+		// chase the first k chains of the
+		// same memory, with the kernel for k
+		for (int64 k = 1; k <= chains; k++) {
+			if (this->thread_id() == 0) {
+				this->exp->chains_per_thread = k;
+				this->exp->iterations = iterations;
+			}
+			this->bp->barrier();
+
+			size_t first = Run::_seconds.size();
+			this->measure(benches[k - 1], root);
+
+			if (this->thread_id() == 0) {
+				double seconds = 0;
+				for (size_t i = first; i < Run::_seconds.size(); i++)
+					seconds += Run::_seconds[i];
+				if (first < Run::_seconds.size())
+					seconds /= Run::_seconds.size() - first;
+				Run::_mlp_iterations.push_back(this->exp->iterations);
+				Run::_mlp_seconds.push_back(seconds);
+			}
+		}
+	} else {
+		this->measure(benches[0], root);
+	}
+
+	// clean the memory
+	delete[] this->regions;
+	this->regions = NULL;
+	if (chain_memory != NULL
+		) delete[] chain_memory;
+
+	return 0;
+}
+
+// time the first touch of fresh chain memory by
+// the first k threads, for k from 1 to all threads.
+// every experiment maps the memory anew, outside
+// the timed part, and unmaps it afterwards.
+int Run::fault() {
+	int64 chains = this->exp->chains_per_thread;
+	int64 bytes = this->exp->bytes_per_chain;
+
+#if defined(NUMA)
+	numa_run_on_node(this->exp->thread_domain[this->thread_id()]);
+#endif
+
+	for (int64 k = 1; k <= this->exp->num_threads; k++) {
+		bool faults = this->thread_id() < k;
+		double seconds = 0;
+		for (int e = 0; e < this->exp->experiments; e++) {
+			Memory* regions = new Memory[chains];
+			if (faults) {
+				for (int i = 0; i < chains; i++) {
+					int32 domain = 0;
+#if defined(NUMA)
+					domain = this->exp->chain_domain[this->thread_id()][i];
+#endif
+					regions[i].map(*this->exp, bytes, domain, this->thread_id() * chains + i);
+				}
+			}
+
+			// the page cache would keep file pages from
+			// one experiment for the next, so every one
+			// starts from holes, or with --cold from
+			// pages written back and dropped
+			if (faults && this->exp->backing_file != NULL) {
+				for (int i = 0; i < chains; i++) {
+					if (this->exp->cold) {
+						regions[i].touch();
+						regions[i].evict();
+					} else {
+						regions[i].discard();
+					}
+				}
+			}
+
+			// start timer
+			this->bp->barrier();
+			double start = 0;
+			if (this->thread_id() == 0)
+				start = Timer::seconds();
+			this->bp->barrier();
+
+			if (faults) {
+				for (int i = 0; i < chains; i++) {
+					regions[i].touch();
+				}
+			}
+
+			// stop timer
+			this->bp->barrier();
+			if (this->thread_id() == 0) {
+				seconds += Timer::seconds() - start;
+
+				// the mapping is rounded up to the pages,
+				// so a chain below a page faults one
+				int64 page_size = regions[0].page_size();
+				Run::global_mutex.lock();
+				this->exp->backing_page_size = page_size;
+				Run::_ops_per_chain = (regions[0].size() + page_size - 1) / page_size;
+				Run::global_mutex.unlock();
+			}
+			this->bp->barrier();
+
+			delete[] regions;
+		}
+
+		if (this->thread_id() == 0) {
+			Run::_fault_seconds.push_back(seconds / this->exp->experiments);
+		}
+	}
+
+	return 0;
+}
+
+// the kernels the thread runs, one for each
+// step of the sweep, or just the one otherwise
+std::vector<benchmark> Run::kernels(int32 domain) {
+	std::vector<benchmark> benches;
+	if (this->exp->mlp) {
+		for (int64 k = 1; k <= this->exp->chains_per_thread; k++) {
+			Experiment step = *this->exp;
+			step.chains_per_thread = k;
+			benches.push_back(Kernel::get(step, domain));
+		}
+	} else {
+		benches.push_back(Kernel::get(*this->exp, domain));
+	}
+
+	return benches;
+}
+
+// calibrate the iterations when needed, then
+// time all experiments of the benchmark
+void Run::measure(benchmark bench, Chain** root) {
 	// calculate the number of iterations
 	/*
 	 * As soon as the thread count rises, this calculation HUGELY
@@ -119,6 +346,11 @@ int Run::run() {
 		volatile static double elapsed = 0;
 		volatile static int64 iters = 1;
 		volatile double bound = std::max(0.2, 10 * Timer::resolution());
+		// the statics carry over from an earlier sweep step
+		if (this->thread_id() == 0) {
+			elapsed = 0;
+		}
+		this->bp->barrier();
 		for (iters = 1; elapsed <= bound; iters = iters << 1) {
 			// barrier
 			this->bp->barrier();
@@ -130,8 +362,7 @@ int Run::run() {
 			this->bp->barrier();
 
 			// chase pointers
-			for (int i = 0; i < iters; i++)
-				bench(root);
+			bench(root, this->passes(iters));
 
 			// barrier
 			this->bp->barrier();
@@ -159,6 +390,10 @@ int Run::run() {
 
 	// run the experiments
 	for (int e = 0; e < this->exp->experiments; e++) {
+		if (this->exp->cold) {
+			this->evict();
+		}
+
 		// barrier
 		this->bp->barrier();
 
@@ -169,8 +404,7 @@ int Run::run() {
 		this->bp->barrier();
 
 		// chase pointers
-		for (int i = 0; i < this->exp->iterations; i++)
-			bench(root);
+		bench(root, this->passes(this->exp->iterations));
 
 		// barrier
 		this->bp->barrier();
@@ -192,16 +426,24 @@ int Run::run() {
 	}
 
 	this->bp->barrier();
+}
 
-	// clean the memory
-	for (int i = 0; i < this->exp->chains_per_thread; i++) {
-		if (chain_memory[i] != NULL
-			) delete[] chain_memory[i];
+// drop the chains from memory, so the
+// experiment faults them in again
+void Run::evict() {
+	for (int64 i = 0; i < this->region_count; i++) {
+		this->regions[i].evict();
 	}
-	if (chain_memory != NULL
-		) delete[] chain_memory;
+}
 
-	return 0;
+// the benchmark loops internally, chasing unroll
+// links per chain for every pass
+int64 Run::passes(int64 iterations) {
+	// the STREAM kernels sweep all elements every pass
+	if (this->exp->is_stream())
+		return iterations;
+
+	return this->exp->hops(Run::_ops_per_chain, iterations) / this->exp->unroll;
 }
 
 int dummy = 0;
@@ -219,227 +461,466 @@ static const int prime_table[] = { 5, 11, 13, 17, 19, 23, 37, 41, 43, 47, 53,
 static const int prime_table_size = sizeof prime_table / sizeof prime_table[0];
 
 Chain*
-Run::random_mem_init(Chain *mem) {
+Run::random_mem_init(Chain *mem, int32 domain) {
 	// initialize pointers --
 	// choose a page at random, then use
 	// one pointer from each cache line
 	// within the page.  all pages and
 	// cache lines are chosen at random.
-	Chain* root = 0;
-	Chain* prev = 0;
-	int link_within_line = 0;
-	int64 local_ops_per_chain = 0;
+	Segment proto;
+	proto.mem = mem;
+	proto.factor = prime_table[this->rng.below(prime_table_size)];
+	proto.offset = this->rng.below(this->exp->pages_per_chain);
+	proto.key = this->rng.next();
+
+	return this->parallel_init(proto, this->exp->pages_per_chain,
+			&Run::random_segment_init, domain);
+}
 
-	// we must set a lock because random()
-	// is not thread safe
-	Run::global_mutex.lock();
-	setstate(this->exp->random_state[this->thread_id()]);
-	int page_factor = prime_table[random() % prime_table_size];
-	int page_offset = random() % this->exp->pages_per_chain;
-	Run::global_mutex.unlock();
+// link the lines of pages begin to end of
+// the random page order. every page draws
+// its line order from its own stream, so
+// the layout does not depend on the helpers
+void Run::random_segment_init(Segment &s) {
+	Random page_rng;
 
 	// loop through the pages
-	for (int i = 0; i < this->exp->pages_per_chain; i++) {
-		int page = (page_factor * i + page_offset) % this->exp->pages_per_chain;
-		Run::global_mutex.lock();
-		setstate(this->exp->random_state[this->thread_id()]);
-		int line_factor = prime_table[random() % prime_table_size];
-		int line_offset = random() % this->exp->lines_per_page;
-		Run::global_mutex.unlock();
+	for (int64 i = s.begin; i < s.end; i++) {
+		int64 page = (s.factor * i + s.offset) % this->exp->pages_per_chain;
+		page_rng.seed(s.key, i);
+		int line_factor = prime_table[page_rng.below(prime_table_size)];
+		int line_offset = page_rng.below(this->exp->lines_per_page);
 
 		// loop through the lines within a page
 		for (int j = 0; j < this->exp->lines_per_page; j++) {
 			int line_within_page = (line_factor * j + line_offset)
 					% this->exp->lines_per_page;
-			int link = page * this->exp->links_per_page
-					+ line_within_page * this->exp->links_per_line
-					+ link_within_line;
+			int64 line = page * this->exp->lines_per_page + line_within_page;
 
-			if (root == 0) {
-				prev = root = mem + link;
-				local_ops_per_chain += 1;
-			} else {
-				prev->next = mem + link;
-				prev = prev->next;
-				local_ops_per_chain += 1;
-			}
+			s.append(this->link(s.mem, line));
 		}
 	}
+}
 
-	prev->next = root;
+Chain*
+Run::window_mem_init(Chain *mem, int32 domain) {
+	Segment proto;
+	proto.mem = mem;
+	proto.key = this->rng.next();
+
+	int64 window_lines = this->exp->window / this->exp->line_stride();
+	int64 windows = (this->exp->lines_per_chain + window_lines - 1) / window_lines;
+	return this->parallel_init(proto, windows, &Run::window_segment_init, domain);
+}
+
+// visit windows begin to end in order, and
+// the lines of each window in random order,
+// drawn from the window's own stream
+void Run::window_segment_init(Segment &s) {
+	int64 window_lines = this->exp->window / this->exp->line_stride();
+	std::vector<int64> order(window_lines);
+	Random window_rng;
+
+	for (int64 w = s.begin; w < s.end; w++) {
+		int64 first = w * window_lines;
+		int64 lines = std::min(window_lines, this->exp->lines_per_chain - first);
+
+		// Fisher-Yates shuffle of the lines
+		window_rng.seed(s.key, w);
+		for (int64 j = 0; j < lines; j++) {
+			order[j] = j;
+		}
+		for (int64 j = lines - 1; 0 < j; j--) {
+			std::swap(order[j], order[window_rng.below(j + 1)]);
+		}
+
+		for (int64 j = 0; j < lines; j++) {
+			int64 line = first + order[j];
+			s.append(this->link(s.mem, line));
+		}
+	}
+}
+
+// link all lines of the chain into a single
+// cycle, chosen uniformly at random among all
+// cycles by Sattolo's algorithm, so there are
+// no pages or strides for the hardware to learn
+Chain*
+Run::random_full_mem_init(Chain *mem) {
+	int64 lines = this->exp->lines_per_chain;
+
+	// the next pointers hold line numbers
+	// while the permutation is shuffled
+	for (int64 i = 0; i < lines; i++) {
+		this->link(mem, i)->next = (Chain*) i;
+	}
+
+	for (int64 i = lines - 1; 0 < i; i--) {
+		int64 j = this->rng.below(i);
+		Chain* t = this->link(mem, i)->next;
+		this->link(mem, i)->next = this->link(mem, j)->next;
+		this->link(mem, j)->next = t;
+	}
+
+	// line i is followed by line next[i]
+	for (int64 i = 0; i < lines; i++) {
+		Chain* p = this->link(mem, i);
+		p->next = this->link(mem, (int64) p->next);
+	}
+
+	Chain* root = this->link(mem, 0);
+	this->lookahead_init(root);
 
 	Run::global_mutex.lock();
-	Run::_ops_per_chain = local_ops_per_chain;
+	Run::_ops_per_chain = lines;
 	Run::global_mutex.unlock();
 
 	return root;
 }
 
+// the link of a line, placed at the offset of the
+// experiment, or a random offset drawn from the line
+// number, so every layout finds it in the same place
+Chain* Run::link(Chain* mem, int64 line) {
+	int64 offset = this->exp->link_offset;
+	if (this->exp->random_offset) {
+		// keep the link within the line and aligned
+		int64 slots = (this->exp->line_stride() - this->exp->pointer_size) / sizeof(Chain*) + 1;
+		offset = Random::hash(this->exp->seed, line) % slots * sizeof(Chain*);
+	}
+
+	return (Chain*) ((char*) mem + line * this->exp->line_stride() + offset);
+}
+
+// the links that fit in a line after its link, for
+// the layouts that visit a line more than once
+int64 Run::slots_per_line() {
+	if (!this->exp->random_offset && this->exp->link_offset == 0) {
+		return this->exp->links_per_line;
+	}
+
+	// the links must stay within the line
+	int64 largest = this->exp->random_offset
+			? this->exp->line_stride() - this->exp->pointer_size : this->exp->link_offset;
+	return std::max((int64) 1,
+			(this->exp->line_stride() - largest) / this->exp->pointer_size);
+}
+
+// a multiplier coprime with n, so rank * a % n
+// scatters the ranks over all of 0 .. n-1
+static int64 scatter_factor(int64 n) {
+	for (int64 a = n * 0.6180339887 + 1; ; a++) {
+		int64 x = a, y = n;
+		while (y != 0) {
+			int64 t = x % y;
+			x = y;
+			y = t;
+		}
+		if (x == 1)
+			return a;
+	}
+}
+
+// chain of lines_per_chain draws from a zipf
+// distribution over the lines, by inverting its
+// cumulative distribution. hot ranks are scattered
+// so they do not share pages.
 Chain*
-Run::forward_mem_init(Chain *mem) {
-	Chain* root = 0;
-	Chain* prev = 0;
-	int link_within_line = 0;
-	int64 local_ops_per_chain = 0;
-
-	for (int i = 0; i < this->exp->lines_per_chain; i += this->exp->stride) {
-		int link = i * this->exp->links_per_line + link_within_line;
+Run::zipf_mem_init(Chain *mem) {
+	int64 n = this->exp->lines_per_chain;
+	double theta = this->exp->zipf_theta;
+
+	std::vector<double> cumulative(n);
+	double zetan = 0;
+	for (int64 i = 0; i < n; i++) {
+		zetan += 1.0 / pow((double) (i + 1), theta);
+		cumulative[i] = zetan;
+	}
+	int64 factor = scatter_factor(n);
+	int64 offset = this->rng.below(n);
+
+	std::vector<int64> visits(n);
+	for (int64 k = 0; k < n; k++) {
+		double u = (this->rng.next() >> 11) * (1.0 / 9007199254740992.0);
+		int64 rank = std::upper_bound(cumulative.begin(), cumulative.end(), u * zetan)
+				- cumulative.begin();
+		rank = std::min(rank, n - 1);
+		visits[k] = (rank * factor + offset) % n;
+	}
+
+	return this->visit_mem_init(mem, visits, n);
+}
+
+// chain of the lines in the order of their visits.
+// the k-th visit to a line uses its k-th link, as a
+// link has a single successor. visits beyond the
+// links of the line continue in lines of the overflow
+// area after the chain, each standing in for a single
+// line, or are skipped and counted without one.
+// visits to the line of the previous hop are skipped.
+Chain*
+Run::visit_mem_init(Chain *mem, const std::vector<int64> &visits, int64 overflow_lines) {
+	int64 lines = this->exp->lines_per_chain;
+	int64 links_per_line = this->slots_per_line();
+	std::vector<uint16> used(lines + overflow_lines, 0);
+	std::vector<int64> overflow(lines, -1);
+	int64 next_overflow = lines;
+
+	Chain* root = NULL;
+	Chain* prev = NULL;
+	int64 prev_line = -1;
+	int64 hops = 0;
+	int64 skipped = 0;
+	for (size_t i = 0; i < visits.size(); i++) {
+		int64 line = visits[i];
+		if (line == prev_line) {
+			continue;
+		}
+		prev_line = line;
+
+		int64 slot = line;
+		if (used[slot] == links_per_line) {
+			slot = overflow[line];
+			if (slot < 0 || used[slot] == links_per_line) {
+				if (next_overflow == lines + overflow_lines) {
+					skipped += 1;
+					continue;
+				}
+				slot = next_overflow++;
+				overflow[line] = slot;
+			}
+		}
+
+		Chain* node = (Chain*) ((char*) this->link(mem, slot) + used[slot] * this->exp->pointer_size);
+		used[slot] += 1;
 		if (root == NULL) {
-			prev = root = mem + link;
-			local_ops_per_chain += 1;
+			root = node;
 		} else {
-			prev->next = mem + link;
-			prev = prev->next;
-			local_ops_per_chain += 1;
+			prev->next = node;
 		}
+		prev = node;
+		hops += 1;
 	}
 
 	prev->next = root;
+	this->lookahead_init(root);
 
 	Run::global_mutex.lock();
-	Run::_ops_per_chain = local_ops_per_chain;
+	Run::_ops_per_chain = hops;
+	Run::_skipped_hops += skipped;
 	Run::global_mutex.unlock();
 
 	return root;
 }
 
+// chain of the lines of the trace addresses,
+// in the order of the trace
 Chain*
-Run::reverse_mem_init(Chain *mem) {
-	Chain* root = 0;
-	Chain* prev = 0;
-	int link_within_line = 0;
-	int64 local_ops_per_chain = 0;
-
-	int stride = -this->exp->stride;
-	int last;
-	for (int i = 0; i < this->exp->lines_per_chain; i += stride) {
-		last = i;
-	}
-
-	for (int i = last; 0 <= i; i -= stride) {
-		int link = i * this->exp->links_per_line + link_within_line;
-		if (root == 0) {
-			prev = root = mem + link;
-			local_ops_per_chain += 1;
-		} else {
-			prev->next = mem + link;
-			prev = prev->next;
-			local_ops_per_chain += 1;
-		}
+Run::trace_mem_init(Chain *mem) {
+	Trace* trace = this->exp->trace;
+
+	std::vector<int64> visits(trace->size());
+	for (int64 i = 0; i < trace->size(); i++) {
+		uint64 offset = trace->address(i) - trace->lowest();
+		visits[i] = offset / this->exp->line_stride() % this->exp->lines_per_chain;
+	}
+
+	return this->visit_mem_init(mem, visits, 0);
+}
+
+// relocate the saved offsets of the chain
+// into the memory allocated for it
+Chain*
+Run::load_mem_init(Chain *mem, int64 chain) {
+	const uint64* offsets = this->exp->layout->offsets(this->thread_id(), chain);
+	int64 links = this->exp->layout->links(this->thread_id(), chain);
+
+	Chain* root = (Chain*) ((char*) mem + offsets[0]);
+	Chain* prev = root;
+	for (int64 i = 1; i < links; i++) {
+		Chain* node = (Chain*) ((char*) mem + offsets[i]);
+		prev->next = node;
+		prev = node;
 	}
 
 	prev->next = root;
+	this->lookahead_init(root);
 
 	Run::global_mutex.lock();
-	Run::_ops_per_chain = local_ops_per_chain;
+	Run::_ops_per_chain = links;
 	Run::global_mutex.unlock();
 
 	return root;
 }
 
-static benchmark chase_pointers(asmjit::JitRuntime &rt,	Experiment &exp) {
-	using namespace asmjit;
-	using namespace a64;
-	// Create Compiler.
-	CodeHolder code;                  // Holds code and relocation information.
-  	code.init(rt.environment());      // Initialize code to match the JIT environment. 
-
-	Compiler c(&code);	// Create and attach Compiler to code.
-
-  	// Tell compiler the function prototype we want. It allocates variables representing
-	// function arguments that can be accessed through Compiler or Function instance.
-	FuncNode* funcNode = c.addFunc(FuncSignatureT<void, Chain**>());
-
-	// Try to generate function without prolog/epilog code:
-	// c.getFunction()->setHint(asmjit::FUNCTION_HINT_NAKED, true);
-
-	// Create labels.
-	Label L_Loop = c.newLabel();
-
-	// Function arguments.
-	Gp chain=c.newUIntPtr();
-	funcNode->setArg(0,chain);
-
-
-	// Save the head
-	Gp head = c.newUIntPtr();
-	c.ldr(head, ptr(chain));
-
-	// Current position
-	std::vector<Gp> positions(exp.chains_per_thread);
-	for (int i = 0; i < exp.chains_per_thread; i++) {
-		positions[i] = c.newUIntPtr();
-		c.ldr(positions[i], ptr(chain,i*sizeof(Chain *)));
-	}
-
-	uint32_t val_num=exp.mem_operation==Experiment::STORE_ALL||exp.mem_operation==Experiment::LOAD_ALL?abs(exp.stride):1;
-	std::vector<Gp> vals(val_num);
-	for (uint32_t i = 0; i < val_num; i++) {
-		vals[i] = c.newUInt64();
-		c.mov(vals[i], 100 * i);
-	}
-
-	// Loop.
-	c.bind(L_Loop);
-
-	// Process all links
-	for (int i = 0; i < exp.chains_per_thread; i++) {
-		// Chase pointer
-		c.ldr(positions[i], ptr(positions[i], offsetof(Chain, next)));
-		if(exp.mem_operation==Experiment::LOAD){
-			c.ldr(vals[0], ptr(positions[i], offsetof(Chain, data)));
-		}else if(exp.mem_operation==Experiment::STORE){
-			c.str(vals[0], ptr(positions[i], offsetof(Chain, data)));
-		}else if(exp.mem_operation==Experiment::LOAD_ALL){
-			for (uint32_t j = 0; j < val_num; j++) 
-				c.ldr(vals[j], ptr(positions[i], j*exp.bytes_per_line + offsetof(Chain, data)));
-		}else if(exp.mem_operation==Experiment::STORE_ALL){
-			for (uint32_t j = 0; j < val_num; j++) 
-				c.str(vals[j], ptr(positions[i], j*exp.bytes_per_line + offsetof(Chain, data)));
-		}
+// the offsets of the links of the chains of the
+// thread, from their roots in chasing order. the
+// chains differ in length for some patterns, so the
+// file is created once the links of all chains of
+// all threads are known.
+void Run::save_mem(Chain **mem, Chain **root) {
+	int64 chains = this->exp->chains_per_thread;
+	int64 first = this->thread_id() * chains;
+	std::vector< std::vector<uint64> > offsets(chains);
+	for (int64 i = 0; i < chains; i++) {
+		Chain* p = root[i];
+		do {
+			offsets[i].push_back((char*) p - (char*) mem[i]);
+			p = p->next;
+		} while (p != root[i]);
+	}
+
+	Run::global_mutex.lock();
+	Run::_chain_links.resize(this->exp->num_threads * chains, 0);
+	for (int64 i = 0; i < chains; i++) {
+		Run::_chain_links[first + i] = offsets[i].size();
+	}
+	Run::global_mutex.unlock();
+
+	this->bp->barrier();
+	if (this->thread_id() == 0) {
+		Layout::create(this->exp->save_file, *this->exp, Run::_chain_links);
+	}
+	this->bp->barrier();
+
+	for (int64 i = 0; i < chains; i++) {
+		Layout::save(this->exp->save_file, first + i, Run::_chain_links, offsets[i]);
+	}
+}
+
+Chain*
+Run::forward_mem_init(Chain *mem, int32 domain) {
+	Segment proto;
+	proto.mem = mem;
+
+	int64 stride = this->exp->stride;
+	int64 steps = (this->exp->lines_per_chain + stride - 1) / stride;
+	return this->parallel_init(proto, steps, &Run::forward_segment_init, domain);
+}
+
+void Run::forward_segment_init(Segment &s) {
+	for (int64 i = s.begin; i < s.end; i++) {
+		int64 line = i * this->exp->stride;
+		s.append(this->link(s.mem, line));
+	}
+}
+
+Chain*
+Run::reverse_mem_init(Chain *mem, int32 domain) {
+	Segment proto;
+	proto.mem = mem;
+
+	int64 stride = -this->exp->stride;
+	int64 steps = (this->exp->lines_per_chain + stride - 1) / stride;
+	return this->parallel_init(proto, steps, &Run::reverse_segment_init, domain);
+}
+
+void Run::reverse_segment_init(Segment &s) {
+	// start from the last line of the forward order
+	int64 stride = -this->exp->stride;
+	int64 last = (this->exp->lines_per_chain - 1) / stride * stride;
+	for (int64 i = s.begin; i < s.end; i++) {
+		int64 line = last - i * stride;
+		s.append(this->link(s.mem, line));
+	}
+}
+
+// helper building one segment of a
+// chain within the chain's domain
+class Builder: public Thread {
+public:
+	Builder(Run* run, Run::SegmentInit init, Segment* segment, int32 domain) :
+			owner(run), init(init), segment(segment), domain(domain) {
+	}
+	~Builder() {
+	}
 
-		// Prefetch next
-		// switch (prefetch_hint)
-		// {
-		// case Experiment::T0:
-		// 	c.prefetch(ptr(positions[i]), asmjit::PREFETCH_T0);
-		// 	break;
-		// case Experiment::T1:
-		// 	c.prefetch(ptr(positions[i]), asmjit::PREFETCH_T1);
-		// 	break;
-		// case Experiment::T2:
-		// 	c.prefetch(ptr(positions[i]), asmjit::PREFETCH_T2);
-		// 	break;
-		// case Experiment::NTA:
-		// 	c.prefetch(ptr(positions[i]), asmjit::PREFETCH_NTA);
-		// 	break;
-		// case Experiment::NONE:
-		// default:
-		// 	break;
-		// }
-	}
-
-	// Wait
-	for (int i = 0; i < exp.loop_length; i++)
-		c.nop();
-
-	// Test if end reached
-	c.cmp(head, positions[0]);
-	c.b(CondCode::kNE,L_Loop);
-
-
-	// Finish.
-	c.endFunc();
-	c.finalize();
-
-	// Add the generated code to the runtime.
-  	benchmark fn;
-  	Error err = rt.add(&fn, &code);
-	// Handle a possible error returned by AsmJit.
-	if (err) {
-		printf("Error making jit function (%u).\n", err);
+	int run() {
+#if defined(NUMA)
+		// build close to the memory,
+		// which is bound to the domain
+		numa_run_on_node(this->domain);
+#endif
+		(this->owner->*(this->init))(*this->segment);
 		return 0;
 	}
 
-	return fn;
+private:
+	Run* owner;
+	Run::SegmentInit init;
+	Segment* segment;
+	int32 domain;
+};
+
+// split the steps of a chain into segments,
+// built by this thread and up to build_threads-1
+// helpers, then stitch the segments in order
+// into a single cycle
+Chain* Run::parallel_init(const Segment &proto, int64 steps,
+		SegmentInit init, int32 domain) {
+	int64 count = std::max((int64) 1, std::min(this->exp->build_threads, steps));
+
+	std::vector<Segment> segments(count, proto);
+	for (int64 k = 0; k < count; k++) {
+		segments[k].begin = steps * k / count;
+		segments[k].end = steps * (k + 1) / count;
+		segments[k].first = NULL;
+		segments[k].last = NULL;
+		segments[k].links = 0;
+	}
+
+	std::vector<Builder*> helpers;
+	for (int64 k = 1; k < count; k++) {
+		helpers.push_back(new Builder(this, init, &segments[k], domain));
+		helpers.back()->start();
+	}
+	(this->*init)(segments[0]);
+	for (size_t k = 0; k < helpers.size(); k++) {
+		helpers[k]->wait();
+		delete helpers[k];
+	}
+
+	Chain* root = segments[0].first;
+	int64 local_ops_per_chain = segments[0].links;
+	for (int64 k = 1; k < count; k++) {
+		segments[k - 1].last->next = segments[k].first;
+		local_ops_per_chain += segments[k].links;
+	}
+	segments[count - 1].last->next = root;
+	this->lookahead_init(root);
+
+	Run::global_mutex.lock();
+	Run::_ops_per_chain = local_ops_per_chain;
+	Run::global_mutex.unlock();
+
+	return root;
+}
+
+void Run::data_init(Chain *root) {
+	Chain* p = root;
+	do {
+		p->data = 0;
+		p = p->next;
+	} while (p != root);
+}
+
+// point every link at the link prefetch_distance
+// hops further down the (circular) chain, so the
+// benchmark can prefetch without chasing ahead.
+void Run::lookahead_init(Chain *root) {
+	if (this->exp->prefetch_hint == Experiment::NONE) {
+		return;
+	}
+
+	Chain* lead = root;
+	for (int64 i = 0; i < this->exp->prefetch_distance; i++) {
+		lead = lead->next;
+	}
+
+	Chain* p = root;
+	do {
+		((Lookahead*) p)->ahead = lead;
+		p = p->next;
+		lead = lead->next;
+	} while (p != root);
 }
@@ -29,14 +29,42 @@
 #include "types.h"
 #include "experiment.h"
 #include "spinbarrier.h"
+#include "kernel.h"
+#include "random.h"
 
 
 //
 // Class definition
 //
 
+// a range of the steps (pages or lines) of a chain,
+// linked in order by one thread of the chain's build
+struct Segment {
+	Chain* mem;				// memory of the chain
+	int64 begin, end;		// steps to link
+	int64 factor, offset;	// page order of the random layout
+	uint64 key;				// seed of the random line orders
+	Chain* first;			// first link of the segment
+	Chain* last;			// last link of the segment
+	int64 links;			// links in the segment
+
+	void append(Chain* link) {
+		if (this->first == NULL) {
+			this->first = link;
+		} else {
+			this->last->next = link;
+		}
+		this->last = link;
+		this->links += 1;
+	}
+};
+
+class Memory;
+
 class Run: public Thread {
 public:
+	typedef void (Run::*SegmentInit)(Segment &s);
+
 	Run();
 	~Run();
 	int run();
@@ -45,22 +73,64 @@ public:
 	static int64 ops_per_chain() {
 		return _ops_per_chain;
 	}
+	static int64 skipped_hops() {
+		return _skipped_hops;
+	}
 	static std::vector<double> seconds() {
 		return _seconds;
 	}
+	static std::vector<int64> mlp_iterations() {
+		return _mlp_iterations;
+	}
+	static std::vector<double> mlp_seconds() {
+		return _mlp_seconds;
+	}
+	static std::vector<double> fault_seconds() {
+		return _fault_seconds;
+	}
 
 private:
 	Experiment* exp; // experiment data
 	SpinBarrier* bp; // spin barrier used by all threads
+	Random rng; // random numbers of this thread's chain layouts
+	Memory* regions; // memory of this thread's chains
+	int64 region_count; // number of regions
 
+	int fault();
+	std::vector<benchmark> kernels(int32 domain);
+	void measure(benchmark bench, Chain** root);
+	void evict();
+	int64 passes(int64 iterations);
 	void mem_check(Chain *m);
-	Chain* random_mem_init(Chain *m);
-	Chain* forward_mem_init(Chain *m);
-	Chain* reverse_mem_init(Chain *m);
+	Chain* link(Chain *m, int64 line);
+	int64 slots_per_line();
+	Chain* random_mem_init(Chain *m, int32 domain);
+	Chain* random_full_mem_init(Chain *m);
+	Chain* window_mem_init(Chain *m, int32 domain);
+	Chain* zipf_mem_init(Chain *m);
+	Chain* trace_mem_init(Chain *m);
+	Chain* visit_mem_init(Chain *m, const std::vector<int64> &visits, int64 overflow_lines);
+	Chain* load_mem_init(Chain *m, int64 chain);
+	void save_mem(Chain **m, Chain **root);
+	Chain* forward_mem_init(Chain *m, int32 domain);
+	Chain* reverse_mem_init(Chain *m, int32 domain);
+	void random_segment_init(Segment &s);
+	void forward_segment_init(Segment &s);
+	void window_segment_init(Segment &s);
+	void reverse_segment_init(Segment &s);
+	Chain* parallel_init(const Segment &proto, int64 steps,
+			SegmentInit init, int32 domain);
+	void lookahead_init(Chain *root);
+	void data_init(Chain *root);
 
 	static Lock global_mutex; // global lock
 	static int64 _ops_per_chain; // total number of operations per chain
+	static int64 _skipped_hops; // visits to lines without a free link, all chains
+	static std::vector<uint64> _chain_links; // links of every chain saved
 	static std::vector<double> _seconds; // number of seconds for each experiment
+	static std::vector<int64> _mlp_iterations; // iterations for each sweep step
+	static std::vector<double> _mlp_seconds; // average seconds for each sweep step
+	static std::vector<double> _fault_seconds; // average seconds for each thread count
 };
 
 #endif
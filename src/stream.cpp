@@ -0,0 +1,103 @@
+/*******************************************************************************
+ * Copyright (c) 2006 International Business Machines Corporation.             *
+ * All rights reserved. This program and the accompanying materials            *
+ * are made available under the terms of the Common Public License v1.0        *
+ * which accompanies this distribution, and is available at                    *
+ * http://www.opensource.org/licenses/cpl1.0.php                               *
+ *                                                                             *
+ * Contributors:                                                               *
+ *    Douglas M. Pase - initial API and implementation                         *
+ *    Tim Besard - prefetching, JIT compilation                                *
+ *******************************************************************************/
+
+//
+// Configuration
+//
+
+// Implementation header
+#include "stream.h"
+
+// System includes
+#include <cstdio>
+
+
+//
+// Implementation
+//
+
+/*
+ * The STREAM kernels treat the chains of a thread as flat arrays of
+ * doubles, so they inherit the numa placement of the chains. Copy and
+ * scale use two arrays, add and triad three:
+ *
+ *     copy    b[i] = a[i]
+ *     scale   b[i] = q * a[i]
+ *     add     c[i] = a[i] + b[i]
+ *     triad   a[i] = b[i] + q * c[i]
+ *
+ * Every pass sweeps the whole arrays once. The arrays never alias, so the
+ * compiler vectorises the loops, and the empty asm after each pass keeps
+ * it from merging the passes.
+ */
+
+static const double SCALAR = 3.0;
+
+// elements in each array
+static int64 elements = 0;
+
+template<int KERNEL>
+static void stream(Chain** root, int64 count) {
+	const int64 n = elements;
+	double* __restrict a = (double*) root[0];
+	double* __restrict b = (double*) root[1];
+	double* __restrict c = (KERNEL == Experiment::STREAM_ADD
+			|| KERNEL == Experiment::STREAM_TRIAD) ? (double*) root[2] : 0;
+
+	for (int64 k = 0; k < count; k++) {
+		if (KERNEL == Experiment::STREAM_COPY) {
+			for (int64 i = 0; i < n; i++)
+				b[i] = a[i];
+		} else if (KERNEL == Experiment::STREAM_SCALE) {
+			for (int64 i = 0; i < n; i++)
+				b[i] = SCALAR * a[i];
+		} else if (KERNEL == Experiment::STREAM_ADD) {
+			for (int64 i = 0; i < n; i++)
+				c[i] = a[i] + b[i];
+		} else if (KERNEL == Experiment::STREAM_TRIAD) {
+			for (int64 i = 0; i < n; i++)
+				a[i] = b[i] + SCALAR * c[i];
+		}
+		__asm__ __volatile__("" : : : "memory");
+	}
+}
+
+void stream_init(Chain** arrays, Experiment &exp) {
+	const double values[] = { 1.0, 2.0, 0.0 };
+	int64 n = exp.bytes_per_chain / sizeof(double);
+
+	for (int j = 0; j < exp.chains_per_thread; j++) {
+		double* array = (double*) arrays[j];
+		for (int64 i = 0; i < n; i++)
+			array[i] = values[j % 3];
+	}
+}
+
+benchmark stream_kernel(Experiment &exp) {
+	elements = exp.bytes_per_chain / sizeof(double);
+
+	switch (exp.kernel) {
+	case Experiment::STREAM_COPY:
+		return stream<Experiment::STREAM_COPY>;
+	case Experiment::STREAM_SCALE:
+		return stream<Experiment::STREAM_SCALE>;
+	case Experiment::STREAM_ADD:
+		return stream<Experiment::STREAM_ADD>;
+	case Experiment::STREAM_TRIAD:
+		return stream<Experiment::STREAM_TRIAD>;
+	default:
+		break;
+	}
+
+	printf("Error selecting stream function (unknown kernel).\n");
+	return 0;
+}
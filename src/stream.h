@@ -0,0 +1,37 @@
+/*******************************************************************************
+ * Copyright (c) 2006 International Business Machines Corporation.             *
+ * All rights reserved. This program and the accompanying materials            *
+ * are made available under the terms of the Common Public License v1.0        *
+ * which accompanies this distribution, and is available at                    *
+ * http://www.opensource.org/licenses/cpl1.0.php                               *
+ *                                                                             *
+ * Contributors:                                                               *
+ *    Douglas M. Pase - initial API and implementation                         *
+ *    Tim Besard - prefetching, JIT compilation                                *
+ *******************************************************************************/
+
+//
+// Configuration
+//
+
+// Include guard
+#if !defined(STREAM_H)
+#define STREAM_H
+
+// Local includes
+#include "kernel.h"
+#include "experiment.h"
+
+
+//
+// Function definitions
+//
+
+// fill the arrays of a thread like STREAM does, so
+// first touch places them and they hold no denormals
+void stream_init(Chain** arrays, Experiment &exp);
+
+// select the STREAM kernel of the experiment
+benchmark stream_kernel(Experiment &exp);
+
+#endif
@@ -24,6 +24,8 @@
 
 Lock Thread::_global_lock;
 int Thread::count = 0;
+cpu_set_t Thread::cpus;
+bool Thread::have_cpus = false;
 
 
 //
@@ -32,6 +34,13 @@ int Thread::count = 0;
 
 Thread::Thread() {
 	Thread::global_lock();
+	// threads created by other threads would
+	// otherwise only see the CPU of their creator
+	if (!Thread::have_cpus) {
+		CPU_ZERO(&Thread::cpus);
+		sched_getaffinity(0, sizeof(Thread::cpus), &Thread::cpus);
+		Thread::have_cpus = true;
+	}
 	this->id = Thread::count;
 	Thread::count += 1;
 	Thread::global_unlock();
@@ -46,20 +55,22 @@ int Thread::start() {
 
 void*
 Thread::start_routine(void* p) {
-	// get the current affinity
-	cpu_set_t cs;
-	CPU_ZERO(&cs);
-	sched_getaffinity(0, sizeof(cs), &cs);
-
 	// deduce the amount of CPUs
-	int count = 0;
-	for (; CPU_ISSET(count, &cs); count++);
+	int count = CPU_COUNT(&Thread::cpus);
 
-	// restrict to a single CPU
+	// restrict to a single CPU, the (id % count)-th
+	// of the process, which need not start at CPU 0
+	int cpu = -1;
+	for (int k = ((Thread*) p)->id % count; 0 <= k; k--) {
+		do {
+			cpu++;
+		} while (!CPU_ISSET(cpu, &Thread::cpus));
+	}
+
+	cpu_set_t cs;
 	CPU_ZERO(&cs);
-	size_t size = CPU_ALLOC_SIZE(1);
-	CPU_SET_S(((Thread*) p)->id % count, size, &cs);
-	pthread_setaffinity_np(pthread_self(), size, &cs);
+	CPU_SET(cpu, &cs);
+	pthread_setaffinity_np(pthread_self(), sizeof(cs), &cs);
 
 	// run
 	((Thread*) p)->run();
@@ -47,7 +47,7 @@ public:
 	static void exit();
 
 protected:
-	~Thread();
+	virtual ~Thread();
 	void lock();
 	void unlock();
 	static void global_lock();
@@ -56,6 +56,8 @@ protected:
 private:
 	static void* start_routine(void *);
 	static Lock _global_lock;
+	static cpu_set_t cpus; // CPUs of the process, as the first thread found them
+	static bool have_cpus;
 
 	Lock object_lock;
 
@@ -0,0 +1,154 @@
+/*******************************************************************************
+ * Copyright (c) 2006 International Business Machines Corporation.             *
+ * All rights reserved. This program and the accompanying materials            *
+ * are made available under the terms of the Common Public License v1.0        *
+ * which accompanies this distribution, and is available at                    *
+ * http://www.opensource.org/licenses/cpl1.0.php                               *
+ *                                                                             *
+ * Contributors:                                                               *
+ *    Douglas M. Pase - initial API and implementation                         *
+ *    Tim Besard - prefetching, JIT compilation                                *
+ *******************************************************************************/
+
+//
+// Configuration
+//
+
+// Implementation header
+#include "trace.h"
+
+// System includes
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+//
+// Implementation
+//
+
+const char Trace::MAGIC[8] = { 'p', 'c', 't', 'r', 'a', 'c', 'e', '1' };
+
+Trace::Trace() :
+		low(0), high(0) {
+}
+
+Trace::~Trace() {
+}
+
+// map the file and read its addresses,
+// printing the reason when it cannot
+int Trace::load(const char* path) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		printf("chase: cannot open trace file '%s'\n", path);
+		return 1;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		printf("chase: trace file '%s' is empty\n", path);
+		close(fd);
+		return 1;
+	}
+
+	void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		printf("chase: cannot map trace file '%s'\n", path);
+		return 1;
+	}
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+	const char* data = (const char*) map;
+	int result;
+	if ((size_t) st.st_size >= sizeof(MAGIC)
+			&& memcmp(data, MAGIC, sizeof(MAGIC)) == 0) {
+		result = this->parse_binary(data, st.st_size, path);
+	} else {
+		result = this->parse_text(data, st.st_size, path);
+	}
+	munmap(map, st.st_size);
+	if (result != 0) {
+		return result;
+	}
+
+	if (this->addresses.empty()) {
+		printf("chase: trace file '%s' holds no addresses\n", path);
+		return 1;
+	}
+	this->low = this->high = this->addresses[0];
+	for (size_t i = 1; i < this->addresses.size(); i++) {
+		if (this->addresses[i] < this->low)
+			this->low = this->addresses[i];
+		if (this->high < this->addresses[i])
+			this->high = this->addresses[i];
+	}
+
+	return 0;
+}
+
+int Trace::parse_binary(const char* data, int64 size, const char* path) {
+	int64 count = (size - sizeof(MAGIC)) / sizeof(uint64);
+	if (sizeof(MAGIC) + count * sizeof(uint64) != (uint64) size) {
+		printf("chase: trace file '%s' ends within an address\n", path);
+		return 1;
+	}
+
+	const uint8* p = (const uint8*) data + sizeof(MAGIC);
+	this->addresses.resize(count);
+	for (int64 i = 0; i < count; i++, p += sizeof(uint64)) {
+		uint64 a = 0;
+		for (int b = sizeof(uint64) - 1; 0 <= b; b--)
+			a = (a << 8) | p[b];
+		this->addresses[i] = a;
+	}
+
+	return 0;
+}
+
+// addresses are the first field of their line, in
+// hexadecimal with or without 0x, like perf prints
+// them. blank lines and # comments are skipped.
+int Trace::parse_text(const char* data, int64 size, const char* path) {
+	int64 line = 1;
+	for (int64 i = 0; i < size; line++) {
+		while (i < size && (data[i] == ' ' || data[i] == '\t'))
+			i++;
+
+		if (i < size && data[i] != '\n' && data[i] != '\r' && data[i] != '#') {
+			if (i + 1 < size && data[i] == '0' && (data[i + 1] == 'x' || data[i + 1] == 'X'))
+				i += 2;
+
+			uint64 a = 0;
+			int digits = 0;
+			for (; i < size; i++, digits++) {
+				char c = data[i];
+				if ('0' <= c && c <= '9') {
+					a = (a << 4) | (c - '0');
+				} else if ('a' <= c && c <= 'f') {
+					a = (a << 4) | (c - 'a' + 10);
+				} else if ('A' <= c && c <= 'F') {
+					a = (a << 4) | (c - 'A' + 10);
+				} else {
+					break;
+				}
+			}
+			if (digits == 0 || 16 < digits) {
+				printf("chase: invalid address on line %lld of trace file '%s'\n", line, path);
+				return 1;
+			}
+			this->addresses.push_back(a);
+		}
+
+		// skip the rest of the line
+		while (i < size && data[i] != '\n')
+			i++;
+		i++;
+	}
+
+	return 0;
+}
@@ -0,0 +1,65 @@
+/*******************************************************************************
+ * Copyright (c) 2006 International Business Machines Corporation.             *
+ * All rights reserved. This program and the accompanying materials            *
+ * are made available under the terms of the Common Public License v1.0        *
+ * which accompanies this distribution, and is available at                    *
+ * http://www.opensource.org/licenses/cpl1.0.php                               *
+ *                                                                             *
+ * Contributors:                                                               *
+ *    Douglas M. Pase - initial API and implementation                         *
+ *    Tim Besard - prefetching, JIT compilation                                *
+ *******************************************************************************/
+
+//
+// Configuration
+//
+
+// Include guard
+#if !defined(TRACE_H)
+#define TRACE_H
+
+// System includes
+#include <vector>
+
+// Local includes
+#include "types.h"
+
+
+//
+// Class definition
+//
+
+// a recorded sequence of memory addresses, in
+// binary form (the magic "pctrace1" followed by
+// little-endian 64-bit addresses) or as text
+// (one hexadecimal address per line)
+class Trace {
+public:
+	Trace();
+	~Trace();
+	int load(const char* path);
+
+	int64 size() {
+		return this->addresses.size();
+	}
+	uint64 address(int64 i) {
+		return this->addresses[i];
+	}
+	uint64 lowest() {
+		return this->low;
+	}
+	uint64 span() {	// bytes from the lowest to the highest address
+		return this->high - this->low + 1;
+	}
+
+	const static char MAGIC[8];
+
+private:
+	int parse_binary(const char* data, int64 size, const char* path);
+	int parse_text(const char* data, int64 size, const char* path);
+
+	std::vector<uint64> addresses;
+	uint64 low, high;
+};
+
+#endif